@@ -0,0 +1,153 @@
+/**
+ * @file   aligner_bench.cpp
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Checks that FrameAligner pairs the frames taken on the same sync pulse.
+ *
+ * The rings of two synchronized cameras are filled with frames whose block IDs and host
+ * timestamps follow the pulses, some of them lost, and every tuple must hold frames of a
+ * single pulse. Covers cameras starting at different block IDs, a camera losing its first
+ * frames so its block IDs are anchored on the wrong pulse, frames lost mid-stream and
+ * block ID wraps.
+ * Exits with a non-zero status if a check fails.
+ */
+
+#include <cstdio>
+#include <deque>
+#include <vector>
+#include "frame_aligner.h"
+
+using namespace std;
+
+static bool allOk = true;
+
+void check(bool ok, const char *what) {
+	printf("%-58s %s\n", what, ok ? "ok" : "FAILED");
+	allOk = allOk && ok;
+}
+
+static const uint64_t periodNs = 33333333;
+
+/**
+ * Frames one camera delivered.
+ */
+struct CameraScript {
+	uint64_t firstBlockId;		//* Block ID of pulse 0
+	uint64_t latencyNs;		//* Retrieval delay after the pulse
+	vector<uint64_t> pulses;	//* Pulses the camera delivered a frame for
+};
+
+vector<uint64_t> pulseRange(uint64_t from, uint64_t to, const vector<uint64_t> &lost = vector<uint64_t>()) {
+	vector<uint64_t> pulses;
+	for (uint64_t pulse = from; pulse < to; ++pulse) {
+		bool isLost = false;
+		for (uint64_t l : lost) {
+			isLost = isLost || l == pulse;
+		}
+		if (!isLost) {
+			pulses.push_back(pulse);
+		}
+	}
+	return pulses;
+}
+
+struct AlignResult {
+	uint64_t tuples = 0;
+	uint64_t incompleteTuples = 0;
+	uint64_t reanchors = 0;
+	vector<uint64_t> misses;
+	bool samePulse = true;	//* Every tuple held frames of one pulse
+};
+
+/**
+ * Fills one ring per camera with the scripted frames, FrameSlot::id holding the pulse,
+ * and drains them through the aligner.
+ */
+AlignResult align(const vector<CameraScript> &cameras, AlignMode mode) {
+	deque<FrameRing> ringStorage;	// Stays in place as rings are added, unlike a vector
+	vector<FrameRing *> rings;
+	for (const CameraScript &camera : cameras) {
+		ringStorage.emplace_back(camera.pulses.size() + 1, 1);
+		FrameRing *ring = &ringStorage.back();
+		for (uint64_t pulse : camera.pulses) {
+			FrameSlot *slot = ring->BeginWrite();
+			slot->id = pulse;
+			slot->blockId = camera.firstBlockId + pulse;
+			// Block IDs wrap from 0xFFFF to 1, 0 is never used by GigE Vision streams
+			if (slot->blockId > 0xFFFF) {
+				slot->blockId -= 0xFFFF;
+			}
+			slot->hostTimestamp = periodNs * 10 + pulse * periodNs + camera.latencyNs;
+			ring->CommitWrite();
+		}
+		rings.push_back(ring);
+	}
+
+	FrameAligner aligner(rings, mode, periodNs / 2, periodNs * 4);
+	AlignResult result;
+	vector<FrameSlot *> members;
+	while (aligner.Next(members, 0, true)) {
+		const FrameSlot *first = NULL;
+		for (const FrameSlot *member : members) {
+			if (member != NULL && first != NULL && member->id != first->id) {
+				result.samePulse = false;
+			}
+			first = first != NULL ? first : member;
+		}
+		aligner.Commit(members);
+	}
+	result.tuples = aligner.GetTuples();
+	result.incompleteTuples = aligner.GetIncompleteTuples();
+	result.reanchors = aligner.GetReanchors();
+	for (size_t i = 0; i < rings.size(); ++i) {
+		result.misses.push_back(aligner.GetMisses(i));
+	}
+	return result;
+}
+
+void checkBlockIds() {
+	{
+		AlignResult r = align({{100, 2000000, pulseRange(0, 50)}, {5000, 3000000, pulseRange(0, 50)}},
+				AlignMode::BlockId);
+		check(r.samePulse && r.tuples == 50 && r.incompleteTuples == 0 && r.reanchors == 0,
+				"block ID: cameras starting at different block IDs");
+	}
+	{
+		AlignResult r = align({{100, 2000000, pulseRange(0, 50)}, {5000, 3000000, pulseRange(1, 50)}},
+				AlignMode::BlockId);
+		check(r.samePulse && r.tuples == 49 && r.incompleteTuples == 1 && r.misses[1] == 1 && r.reanchors == 1,
+				"block ID: second camera lost its first frame");
+	}
+	{
+		// The sources start in reverse order, so the first camera can start pulses late
+		AlignResult r = align({{100, 2000000, pulseRange(3, 50)}, {5000, 3000000, pulseRange(0, 50)}},
+				AlignMode::BlockId);
+		check(r.samePulse && r.tuples == 47 && r.incompleteTuples == 3 && r.misses[0] == 3 && r.reanchors == 1,
+				"block ID: first camera started three pulses late");
+	}
+	{
+		AlignResult r = align({{100, 2000000, pulseRange(0, 50, {10, 11})}, {5000, 3000000, pulseRange(0, 50, {30})}},
+				AlignMode::BlockId);
+		check(r.samePulse && r.tuples == 47 && r.misses[0] == 2 && r.misses[1] == 1 && r.reanchors == 0,
+				"block ID: frames lost mid-stream");
+	}
+	{
+		AlignResult r = align({{0xFFF0, 2000000, pulseRange(1, 50)}, {40, 3000000, pulseRange(0, 50, {20})}},
+				AlignMode::BlockId);
+		check(r.samePulse && r.tuples == 48 && r.misses[0] == 1 && r.misses[1] == 1 && r.reanchors == 1,
+				"block ID: wrap around after a lost first frame");
+	}
+}
+
+void checkHostTimestamps() {
+	AlignResult r = align({{100, 2000000, pulseRange(1, 50, {20})}, {5000, 12000000, pulseRange(0, 50)}},
+			AlignMode::HostTimestamp);
+	check(r.samePulse && r.tuples == 48 && r.misses[0] == 2 && r.misses[1] == 0 && r.reanchors == 0,
+			"host timestamp: lost frames");
+}
+
+int main() {
+	checkBlockIds();
+	checkHostTimestamps();
+	return allOk ? 0 : 1;
+}
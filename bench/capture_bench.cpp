@@ -0,0 +1,199 @@
+/**
+ * @file   capture_bench.cpp
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  End to end capture path benchmark on synthetic frames.
+ *
+ * Runs an unpaced SimulatedCamera through the same stages as tau2_capture for every
+ * output format at every Tau2 resolution and prints one JSON object per run to stdout.
+ * The stages run one after another on a single thread so each one can be timed:
+ *   acquire  RetreiveBuffer() of the source
+ *   copy     masking into a FrameRing slot and taking it out again
+ *   convert  FrameWriter::Convert(), only the celsius format does work here
+ *   encode   FrameWriter::Encode()
+ *   write    FrameWriter::Flush() to the output (default /dev/null)
+ * The segments format copies into 256 MB mapped segment files in a directory (default
+ * /tmp) instead, where encode includes the copy, and removes them afterwards.
+ *
+ * Usage: capture_bench [-n frames] [-o output] [-d directory]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "frame_kernels.h"
+#include "frame_ring.h"
+#include "frame_writer.h"
+#include "segment_recording.h"
+#include "simulated_camera.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+struct Resolution {
+	int width;
+	int height;
+};
+
+/**
+ * Frame sizes of CameraSerialSettings::Resolution.
+ */
+static const Resolution resolutions[] = { { 640, 512 }, { 336, 256 }, { 160, 120 } };
+static const char *const formats[] = { "matrix", "list", "celsius", "raw", "segments" };
+static const uint64_t segmentBytes = 256ull << 20;
+static const char *const stageNames[] = { "acquire", "copy", "convert", "encode", "write" };
+static const int stageCount = 5;
+
+FrameWriter *createWriter(const string &format, int fd, const string &segments, int width, int height,
+		TemperatureLutSource &radiometry) {
+	if (format == "segments") {
+		return new SegmentFrameWriter(segments, segmentBytes, width, height);
+	} else if (format == "matrix") {
+		return new TextFrameWriter(fd, width, height, TextLayout::Matrix);
+	} else if (format == "list") {
+		return new TextFrameWriter(fd, width, height, TextLayout::PixelList);
+	} else if (format == "celsius") {
+		return new CelsiusFrameWriter(fd, width, height, radiometry);
+	}
+	return new RawFrameWriter(fd, width, height);
+}
+
+double processCpuS() {
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @return the given percentile of sorted samples in microseconds
+ */
+double percentileUs(const vector<double> &sorted, double percentile) {
+	size_t i = (size_t) (percentile / 100.0 * (sorted.size() - 1) + 0.5);
+	return sorted[i] * 1e6;
+}
+
+void runBenchmark(const Resolution &resolution, const string &format, int frames, int fd, const string &directory) {
+	SimulationOptions sim;
+	sim.width = resolution.width;
+	sim.height = resolution.height;
+	sim.paced = false;
+	sim.ffcPeriodS = 0.0;
+
+	SimulatedCamera camera(sim);
+	FrameRing ring(4, (size_t) sim.width * sim.height);
+	string segments = directory + "/capture_bench.t2s";
+	FrameWriter *writer = createWriter(format, fd, segments, sim.width, sim.height, camera.GetRadiometry());
+	vector<vector<double> > samples(stageCount, vector<double>(frames));
+	bool failed = false;
+
+	camera.StartAcquisition();
+	double cpuStart = processCpuS();
+	Clock::time_point start = Clock::now();
+	for (int f = 0; f < frames; ++f) {
+		Clock::time_point t0 = Clock::now();
+		const uint16_t *buffer = camera.RetreiveBuffer();
+
+		Clock::time_point t1 = Clock::now();
+		FrameSlot *slot = ring.BeginWrite();
+		slot->id = f;
+		slot->timestamp = camera.GetBufferTimestamp();
+		slot->sensorTemperatureC = sim.sensorTemperatureC;
+		slot->housingTemperatureC = sim.housingTemperatureC;
+		slot->shutterTemperatureC = sim.housingTemperatureC;
+		maskRaw14(buffer, slot->pixels.data(), slot->pixels.size());
+		ring.CommitWrite();
+		camera.ReleaseBuffer();
+		const FrameSlot *frame = ring.BeginRead();
+
+		Clock::time_point t2 = Clock::now();
+		writer->Convert(*frame);
+		Clock::time_point t3 = Clock::now();
+		writer->Encode(*frame);
+		Clock::time_point t4 = Clock::now();
+		failed |= !writer->Flush();
+		ring.CommitRead();
+		Clock::time_point t5 = Clock::now();
+
+		samples[0][f] = chrono::duration<double>(t1 - t0).count();
+		samples[1][f] = chrono::duration<double>(t2 - t1).count();
+		samples[2][f] = chrono::duration<double>(t3 - t2).count();
+		samples[3][f] = chrono::duration<double>(t4 - t3).count();
+		samples[4][f] = chrono::duration<double>(t5 - t4).count();
+	}
+	double elapsedS = chrono::duration<double>(Clock::now() - start).count();
+	double cpuS = processCpuS() - cpuStart;
+	camera.StopAcquisition();
+
+	printf("{\"resolution\":\"%dx%d\",\"format\":\"%s\",\"isa\":\"%s\",\"compiler\":\"%s\","
+			"\"frames\":%d,\"fps\":%.1f,\"cpu_ms_per_frame\":%.3f,\"bytes_per_frame\":%llu,\"ok\":%s,\"stages\":{",
+			resolution.width, resolution.height, format.c_str(), frameKernelsIsa(), __VERSION__,
+			frames, frames / elapsedS, cpuS * 1e3 / frames,
+			(unsigned long long) (writer->GetBytesWritten() / frames), failed ? "false" : "true");
+	for (int s = 0; s < stageCount; ++s) {
+		vector<double> &sorted = samples[s];
+		sort(sorted.begin(), sorted.end());
+		printf("%s\"%s\":{\"p50_us\":%.1f,\"p90_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}",
+				s > 0 ? "," : "", stageNames[s], percentileUs(sorted, 50.0), percentileUs(sorted, 90.0),
+				percentileUs(sorted, 99.0), sorted.back() * 1e6);
+	}
+	printf("}}\n");
+	fflush(stdout);
+
+	if (format == "segments") {
+		uint32_t count = ((SegmentFrameWriter *) writer)->GetSegmentCount();
+		delete writer;
+		for (uint32_t i = 0; i < count; ++i) {
+			unlink(segmentPath(segments, i).c_str());
+		}
+	} else {
+		delete writer;
+	}
+}
+
+int main(int argc, char **argv) {
+	int frames = 200;
+	const char *outputPath = "/dev/null";
+	string directory = "/tmp";
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:o:d:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			frames = atoi(optarg);
+			break;
+		case 'o':
+			outputPath = optarg;
+			break;
+		case 'd':
+			directory = optarg;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n frames] [-o output] [-d directory]\n", argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+	if (frames <= 0) {
+		fprintf(stderr, "Frame count must be positive\n");
+		return 1;
+	}
+
+	int fd = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror(outputPath);
+		return 1;
+	}
+	for (const Resolution &resolution : resolutions) {
+		for (const char *format : formats) {
+			runBenchmark(resolution, format, frames, fd, directory);
+		}
+	}
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,233 @@
+/**
+ * @file   ffc_bench.cpp
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Checks when FFCScheduler runs flat field corrections and which frames it drops.
+ *
+ * A scripted camera, a SimulatedCamera whose housing temperature follows a script and whose
+ * FFC only takes a fixed time, checks the drift and interval triggers, the gaps between
+ * measurement windows, the settle time and the switch to manual FFC and back. A paced
+ * SimulatedCamera is then streamed while the scheduler runs, and the frames of every FFC
+ * must be dropped, or only tagged when frames are kept.
+ * Exits with a non-zero status if a check fails.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ffc_scheduler.h"
+#include "simulated_camera.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static bool allOk = true;
+
+void check(bool ok, const char *what) {
+	printf("%-58s %s\n", what, ok ? "ok" : "FAILED");
+	allOk = allOk && ok;
+}
+
+double secondsSince(Clock::time_point start) {
+	return chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Camera whose housing temperature is a function of the time since construction and whose
+ * FFC takes ffcS without needing frames to be retrieved.
+ */
+class ScriptedCamera : public SimulatedCamera {
+public:
+	ScriptedCamera(function<double(double)> housingC, double ffcS = 0.05) :
+			SimulatedCamera(SimulationOptions()), housingC(housingC), ffcS(ffcS) {
+	}
+
+	double GetHousingTemperature() {
+		return housingC(secondsSince(created));
+	}
+
+	bool SetManualFFC(bool manual) {
+		lock_guard<mutex> lock(recordMutex);
+		modes.push_back(manual);
+		return true;
+	}
+
+	bool PerformFFC() {
+		{
+			lock_guard<mutex> lock(recordMutex);
+			ffcTimes.push_back(secondsSince(created));
+		}
+		this_thread::sleep_for(chrono::duration<double>(ffcS));
+		return true;
+	}
+
+	vector<double> GetFFCTimes() {
+		lock_guard<mutex> lock(recordMutex);
+		return ffcTimes;
+	}
+
+	vector<bool> GetModes() {
+		lock_guard<mutex> lock(recordMutex);
+		return modes;
+	}
+
+	const Clock::time_point created = Clock::now();
+
+private:
+	function<double(double)> housingC;
+	double ffcS;
+	mutex recordMutex;
+	vector<double> ffcTimes;	//* Seconds after construction
+	vector<bool> modes;		//* Arguments of SetManualFFC()
+};
+
+FFCScheduleOptions scheduleOptions(double driftC, double maxIntervalS, double windowS, double gapS) {
+	FFCScheduleOptions options;
+	options.driftC = driftC;
+	options.maxIntervalS = maxIntervalS;
+	options.windowS = windowS;
+	options.gapS = gapS;
+	options.settleS = 0.05;
+	options.checkIntervalS = 0.02;
+	return options;
+}
+
+/**
+ * Runs the scheduler on the camera for the given time.
+ * @return start times of the FFCs in seconds after the camera was constructed
+ */
+vector<double> runScheduler(ScriptedCamera &camera, const FFCScheduleOptions &options, double runS) {
+	FFCScheduler scheduler(camera, options);
+	scheduler.Start();
+	this_thread::sleep_until(camera.created + chrono::duration_cast<Clock::duration>(chrono::duration<double>(runS)));
+	scheduler.Stop();
+	return camera.GetFFCTimes();
+}
+
+bool within(const vector<double> &times, size_t i, double from, double to) {
+	return i < times.size() && times[i] >= from && times[i] <= to;
+}
+
+void checkTriggers() {
+	{
+		ScriptedCamera camera([](double t) { return t < 0.3 ? 30.0 : 31.0; });
+		vector<double> times = runScheduler(camera, scheduleOptions(0.5, 0.0, 0.0, 0.0), 0.8);
+		check(times.size() == 1 && within(times, 0, 0.3, 0.4), "drift: one FFC right after the housing drifted");
+		vector<bool> modes = camera.GetModes();
+		check(modes.size() == 2 && modes[0] && !modes[1], "manual FFC while running, camera mode restored after");
+	}
+	{
+		ScriptedCamera camera([](double) { return 30.0; });
+		vector<double> times = runScheduler(camera, scheduleOptions(0.5, 0.3, 0.0, 0.0), 0.9);
+		// The interval counts from the end of the previous FFC and its settle time
+		check(times.size() == 2 && within(times, 0, 0.3, 0.36) && within(times, 1, 0.7, 0.76),
+				"interval: FFCs every interval without drift");
+	}
+	{
+		ScriptedCamera camera([](double) { return 30.0; });
+		vector<double> times = runScheduler(camera, scheduleOptions(0.5, 0.0, 0.0, 0.0), 0.5);
+		check(times.empty(), "no FFC without drift or interval");
+	}
+}
+
+void checkWindows() {
+	{
+		// Due a little after the gap at 0.5 s opened, still inside it
+		ScriptedCamera camera([](double t) { return t < 0.55 ? 30.0 : 31.0; });
+		vector<double> times = runScheduler(camera, scheduleOptions(0.5, 0.0, 0.5, 0.2), 1.2);
+		check(times.size() == 1 && within(times, 0, 0.55, 0.62), "window: FFC due inside a gap runs in that gap");
+	}
+	{
+		// Due in the middle of the second window, waits for the gap at 1.0 s
+		ScriptedCamera camera([](double t) { return t < 0.75 ? 30.0 : 31.0; });
+		vector<double> times = runScheduler(camera, scheduleOptions(0.5, 0.0, 0.5, 0.1), 1.3);
+		check(times.size() == 1 && within(times, 0, 1.0, 1.06), "window: FFC due in a window waits for the next gap");
+	}
+}
+
+void checkSettle() {
+	ScriptedCamera camera([](double t) { return t < 0.1 ? 30.0 : 31.0; }, 0.1);
+	FFCScheduleOptions options = scheduleOptions(0.5, 0.0, 0.0, 0.0);
+	options.settleS = 0.15;
+	FFCScheduler scheduler(camera, options);
+	Clock::time_point activeFrom, activeTo;
+	bool seen = false;
+
+	scheduler.Start();
+	while (secondsSince(camera.created) < 0.8) {
+		bool active = scheduler.IsFFCActive();
+		if (active && !seen) {
+			activeFrom = Clock::now();
+			seen = true;
+		}
+		if (active) {
+			activeTo = Clock::now();
+		}
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	scheduler.Stop();
+	double activeS = chrono::duration<double>(activeTo - activeFrom).count();
+	check(seen && activeS >= 0.24 && activeS <= 0.3, "settle: active for the FFC plus the settle time");
+	check(scheduler.GetFFCCount() == 1 && !scheduler.IsFFCActive(), "settle: inactive once settled");
+}
+
+/**
+ * Streams a paced simulated camera through TagFrame() while FFCs run every intervalS.
+ */
+void checkFrames(bool dropFrames) {
+	SimulationOptions simulation;
+	simulation.width = 32;
+	simulation.height = 32;
+	simulation.rateHz = 100.0;
+	simulation.ffcDurationS = 0.2;
+	SimulatedCamera camera(simulation);
+	FFCScheduleOptions options = scheduleOptions(100.0, 0.4, 0.0, 0.0);
+	options.dropFrames = dropFrames;
+	FFCScheduler scheduler(camera, options);
+	unsigned frames = 0, dropped = 0, tagged = 0, frozenKept = 0;
+
+	camera.StartAcquisition();
+	scheduler.Start();
+	Clock::time_point start = Clock::now();
+	while (secondsSince(start) < 1.5) {
+		if (camera.RetreiveBuffer() == NULL) {
+			break;
+		}
+		uint32_t flags = camera.GetBufferFlags();
+		bool frozen = flags & frameFlagFFC;
+		++frames;
+		if (scheduler.TagFrame(flags)) {
+			++dropped;
+		} else {
+			tagged += (flags & frameFlagFFC) ? 1 : 0;
+			frozenKept += frozen ? 1 : 0;
+		}
+		camera.ReleaseBuffer();
+	}
+	scheduler.Stop();
+	camera.StopAcquisition();
+
+	// Each FFC freezes 20 frames and is followed by 5 settle frames
+	uint64_t ffcs = scheduler.GetFFCCount();
+	if (dropFrames) {
+		check(ffcs >= 2 && dropped >= ffcs * 20 && dropped <= ffcs * 28 && frozenKept == 0 && tagged == 0,
+				"frames: frozen and settling frames dropped");
+	} else {
+		check(ffcs >= 2 && dropped == 0 && tagged >= ffcs * 20 && tagged <= ffcs * 28,
+				"frames: frozen and settling frames kept and tagged");
+	}
+	printf("  %u frames, %llu FFCs, %u dropped, %u tagged\n", frames, (unsigned long long) ffcs, dropped, tagged);
+}
+
+int main() {
+	checkTriggers();
+	checkWindows();
+	checkSettle();
+	checkFrames(true);
+	checkFrames(false);
+	return allOk ? 0 : 1;
+}
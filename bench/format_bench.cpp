@@ -0,0 +1,75 @@
+/**
+ * @file   format_bench.cpp
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Compares TextFrameWriter against the former cout-per-pixel output on a synthetic 640x512 frame.
+ *
+ * Both paths write to /dev/null so only the formatting cost is measured.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include "frame_writer.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static const int width = 640;
+static const int height = 512;
+
+/**
+ * The per pixel output loop as it was in retrievePixelValues().
+ */
+void coutPixelValues(ostream &out, const uint16_t *in_f16) {
+	int idx = 0;
+
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			idx = y * width + x;
+			uint16_t raw = in_f16[idx];
+			out << "Row: " << y << " Column: " << x << " Raw: " << raw << endl;
+		}
+	}
+}
+
+template <typename F>
+double millisecondsPerFrame(int frames, F writeFrame) {
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < frames; ++i) {
+		writeFrame();
+	}
+	return chrono::duration<double, milli>(Clock::now() - start).count() / frames;
+}
+
+int main() {
+	FrameSlot frame;
+	frame.pixels.resize(width * height);
+	for (int i = 0; i < width * height; ++i) {
+		frame.pixels[i] = (i * 7919) & 0x3FFF;	// 14-bit values of varying length
+	}
+
+	ofstream devNull("/dev/null");
+	int fd = open("/dev/null", O_WRONLY);
+	if (!devNull || fd < 0) {
+		cerr << "Cannot open /dev/null" << endl;
+		return -1;
+	}
+	TextFrameWriter matrix(fd, width, height, TextLayout::Matrix);
+	TextFrameWriter list(fd, width, height, TextLayout::PixelList);
+
+	double coutMs = millisecondsPerFrame(3, [&]() { coutPixelValues(devNull, frame.pixels.data()); });
+	double listMs = millisecondsPerFrame(20, [&]() { list.Write(frame); });
+	double matrixMs = millisecondsPerFrame(50, [&]() { matrix.Write(frame); });
+
+	printf("%-24s %12s %10s\n", "output", "ms/frame", "speedup");
+	printf("%-24s %12.3f %10.1f\n", "cout per pixel", coutMs, 1.0);
+	printf("%-24s %12.3f %10.1f\n", "TextFrameWriter list", listMs, coutMs / listMs);
+	printf("%-24s %12.3f %10.1f\n", "TextFrameWriter matrix", matrixMs, coutMs / matrixMs);
+
+	close(fd);
+	return 0;
+}
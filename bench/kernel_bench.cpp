@@ -0,0 +1,214 @@
+/**
+ * @file   kernel_bench.cpp
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Checks the vectorised frame kernels against their scalar reference and times both.
+ *
+ * Exits with a non-zero status if any kernel disagrees with the scalar path. With -c only
+ * the agreement is checked, over every tail length, odd frame widths, misaligned buffers
+ * and the values 0, 0x3FFF and above 14 bits; make check runs that.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "frame_kernels.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static const int width = 640;
+static const int height = 512;
+static const int frames = 200;
+
+template <typename F>
+double microsecondsPerFrame(F kernel) {
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < frames; ++i) {
+		kernel();
+	}
+	return chrono::duration<double, micro>(Clock::now() - start).count() / frames;
+}
+
+void report(const char *name, double scalarUs, double vectorUs, bool agrees) {
+	printf("%-22s %12.1f %12.1f %8.1f   %s\n", name, scalarUs, vectorUs, scalarUs / vectorUs, agrees ? "ok" : "MISMATCH");
+}
+
+bool floatsAgree(const vector<float> &values, const vector<float> &reference, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		if (fabs(values[i] - reference[i]) > 1e-6f * fabs(reference[i]) + 1e-6f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Runs every kernel and its scalar reference on count values.
+ * @return names of the disagreeing kernels, empty if all agree
+ */
+string compareKernels(const uint16_t *raw, size_t count) {
+	vector<uint16_t> masked(count + 1), maskedRef(count + 1);
+	vector<float> scaled(count + 1), scaledRef(count + 1);
+	vector<uint8_t> agc(count + 1), agcRef(count + 1);
+	string mismatches;
+
+	maskRaw14Scalar(raw, maskedRef.data(), count);
+	maskRaw14(raw, masked.data(), count);
+	if (masked != maskedRef) {
+		mismatches += " maskRaw14";
+	}
+
+	scaleRawScalar(maskedRef.data(), scaledRef.data(), count, 0.04f, -273.15f);
+	linearTemperatureC(maskedRef.data(), scaled.data(), count, 0.04f, -273.15f);
+	if (!floatsAgree(scaled, scaledRef, count)) {
+		mismatches += " linearTemperatureC";
+	}
+	scaleRawScalar(raw, scaledRef.data(), count, 1.0f, 0.0f);
+	rawToFloat(raw, scaled.data(), count);
+	if (!floatsAgree(scaled, scaledRef, count)) {
+		mismatches += " rawToFloat";
+	}
+
+	FrameStatistics statsRef = frameStatisticsScalar(raw, count);
+	FrameStatistics stats = frameStatistics(raw, count);
+	if (stats.min != statsRef.min || stats.max != statsRef.max || stats.mean != statsRef.mean) {
+		mismatches += " frameStatistics";
+	}
+
+	static const uint16_t ranges[][2] = { { 1000, 9000 }, { 0, 0x3FFF }, { 300, 301 }, { 0x3FFF, 0x3FFF }, { 0x4000, 0xFFFF } };
+	for (const auto &range : ranges) {
+		agcToByteScalar(raw, agcRef.data(), count, range[0], range[1]);
+		agcToByte(raw, agc.data(), count, range[0], range[1]);
+		if (agc != agcRef) {
+			mismatches += " agcToByte";
+			break;
+		}
+	}
+	return mismatches;
+}
+
+/**
+ * Compares the kernels on the edge cases of their vector loops.
+ * @return false on any mismatch
+ */
+bool checkKernels() {
+	static const uint16_t edges[] = { 0, 1, 0x3FFE, 0x3FFF, 0x4000, 0x8000, 0xFFFF };
+	static const int widths[] = { 1, 3, 7, 15, 17, 31, 33, 63, 65, 319, 321, 639, 641 };
+	const size_t edgeCount = sizeof(edges) / sizeof(edges[0]);
+	vector<vector<uint16_t>> inputs;
+	vector<string> names;
+	char name[64];
+
+	srand(1);
+	// Every tail length past two of the widest, 16 value, loop steps, edge values at both ends
+	for (size_t count = 0; count <= 40; ++count) {
+		vector<uint16_t> raw(count);
+		for (size_t i = 0; i < count; ++i) {
+			raw[i] = i < edgeCount ? edges[i] : rand() & 0xFFFF;
+		}
+		if (count > 0) {
+			raw[count - 1] = edges[count % edgeCount];
+		}
+		snprintf(name, sizeof(name), "length %zu", count);
+		inputs.push_back(raw);
+		names.push_back(name);
+	}
+	// Frames of odd width, uniform at each edge value and random with edge values mixed in
+	for (int w : widths) {
+		size_t count = (size_t) w * 3;
+		for (size_t e = 0; e <= edgeCount; ++e) {
+			vector<uint16_t> raw(count);
+			for (size_t i = 0; i < count; ++i) {
+				raw[i] = e < edgeCount ? edges[e] : (rand() % 4 == 0 ? edges[rand() % edgeCount] : rand() & 0xFFFF);
+			}
+			if (e < edgeCount) {
+				snprintf(name, sizeof(name), "width %d, all 0x%04X", w, edges[e]);
+			} else {
+				snprintf(name, sizeof(name), "width %d, mixed", w);
+			}
+			inputs.push_back(raw);
+			names.push_back(name);
+		}
+	}
+
+	size_t failures = 0;
+	for (size_t n = 0; n < inputs.size(); ++n) {
+		// Unaligned start as well, as a frame inside a larger buffer would have
+		for (size_t shift = 0; shift < 2; ++shift) {
+			vector<uint16_t> buffer(inputs[n].size() + shift);
+			if (!inputs[n].empty()) {
+				memcpy(buffer.data() + shift, inputs[n].data(), inputs[n].size() * sizeof(uint16_t));
+			}
+			string mismatches = compareKernels(buffer.data() + shift, inputs[n].size());
+			if (!mismatches.empty()) {
+				printf("MISMATCH %s%s:%s\n", names[n].c_str(), shift ? ", unaligned" : "", mismatches.c_str());
+				++failures;
+			}
+		}
+	}
+	printf("Kernels compiled for %s: %zu cases, %zu mismatches\n", frameKernelsIsa(), inputs.size() * 2, failures);
+	return failures == 0;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+		return checkKernels() ? 0 : 1;
+	}
+
+	// Odd length so the scalar tail of every kernel is exercised too
+	const size_t count = width * height + 5;
+	vector<uint16_t> raw(count);
+	vector<uint16_t> masked(count), maskedRef(count);
+	vector<float> scaled(count), scaledRef(count);
+	vector<uint8_t> agc(count), agcRef(count);
+	bool allAgree = true;
+
+	srand(1);
+	for (size_t i = 0; i < count; ++i) {
+		raw[i] = rand() & 0xFFFF;
+	}
+	raw[count / 2] = 0;
+	raw[count / 3] = 0xFFFF;
+
+	printf("Kernels compiled for %s\n", frameKernelsIsa());
+	printf("%-22s %12s %12s %8s\n", "kernel", "scalar us", "vector us", "speedup");
+
+	double s = microsecondsPerFrame([&]() { maskRaw14Scalar(raw.data(), maskedRef.data(), count); });
+	double v = microsecondsPerFrame([&]() { maskRaw14(raw.data(), masked.data(), count); });
+	bool agrees = masked == maskedRef;
+	report("maskRaw14", s, v, agrees);
+	allAgree = allAgree && agrees;
+
+	s = microsecondsPerFrame([&]() { scaleRawScalar(maskedRef.data(), scaledRef.data(), count, 0.04f, -273.15f); });
+	v = microsecondsPerFrame([&]() { linearTemperatureC(maskedRef.data(), scaled.data(), count, 0.04f, -273.15f); });
+	agrees = true;
+	for (size_t i = 0; i < count; ++i) {
+		agrees = agrees && fabs(scaled[i] - scaledRef[i]) <= 1e-6f * fabs(scaledRef[i]) + 1e-6f;
+	}
+	report("linearTemperatureC", s, v, agrees);
+	allAgree = allAgree && agrees;
+
+	FrameStatistics statsRef, stats;
+	s = microsecondsPerFrame([&]() { statsRef = frameStatisticsScalar(raw.data(), count); });
+	v = microsecondsPerFrame([&]() { stats = frameStatistics(raw.data(), count); });
+	agrees = stats.min == statsRef.min && stats.max == statsRef.max && stats.mean == statsRef.mean;
+	report("frameStatistics", s, v, agrees);
+	allAgree = allAgree && agrees;
+
+	s = microsecondsPerFrame([&]() { agcToByteScalar(maskedRef.data(), agcRef.data(), count, 1000, 9000); });
+	v = microsecondsPerFrame([&]() { agcToByte(maskedRef.data(), agc.data(), count, 1000, 9000); });
+	agrees = agc == agcRef;
+	agcToByteScalar(raw.data(), agcRef.data(), count, 300, 301);
+	agcToByte(raw.data(), agc.data(), count, 300, 301);
+	agrees = agrees && agc == agcRef;
+	report("agcToByte", s, v, agrees);
+	allAgree = allAgree && agrees;
+
+	return allAgree ? 0 : 1;
+}
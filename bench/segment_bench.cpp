@@ -0,0 +1,265 @@
+/**
+ * @file   segment_bench.cpp
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Checks that segment recordings read back as written.
+ *
+ * Frames written by SegmentFrameWriter into a temporary directory must read back through
+ * SegmentReader with their pixels, headers and index entries: while the segment is still
+ * written, and after it was finished with the index moved behind the last frame or left
+ * in place. Copies of a finished segment with a corrupt header, index or length must be
+ * rejected by Open() or give no frame, and a segment size that cannot be mapped must fail
+ * the writer.
+ * Exits with a non-zero status if a check fails.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "segment_recording.h"
+
+using namespace std;
+
+static bool allOk = true;
+
+void check(bool ok, const char *what) {
+	printf("%-58s %s\n", what, ok ? "ok" : "FAILED");
+	allOk = allOk && ok;
+}
+
+FrameSlot makeFrame(uint64_t id, int width, int height) {
+	FrameSlot frame;
+	frame.id = id;
+	frame.timestamp = id * 1000 + 1;
+	frame.hostTimestamp = id * 33333333 + 7;
+	frame.blockId = id + 1;
+	frame.pixels.resize(width * height);
+	for (size_t i = 0; i < frame.pixels.size(); ++i) {
+		frame.pixels[i] = (id * 31 + i * 7) & 0x3FFF;
+	}
+	return frame;
+}
+
+/**
+ * @return true if frame i of the segment is the frame with the given id, in its header,
+ *         its index entry and its pixels
+ */
+bool frameMatches(const SegmentReader &reader, uint64_t i, uint64_t id) {
+	const SegmentHeader &segment = reader.GetHeader();
+	FrameSlot expected = makeFrame(id, segment.width, segment.height);
+	const SegmentIndexEntry *entry = reader.GetIndexEntry(i);
+	const RawFrameHeader *header = reader.GetFrameHeader(i);
+	const uint16_t *pixels = reader.GetPixels(i);
+	return entry != NULL && header != NULL && pixels != NULL && entry->frameId == id
+			&& entry->timestamp == expected.timestamp && entry->hostTimestamp == expected.hostTimestamp
+			&& header->frameId == id && header->blockId == expected.blockId
+			&& memcmp(pixels, expected.pixels.data(), expected.pixels.size() * sizeof(uint16_t)) == 0;
+}
+
+/**
+ * @return true if the segment opens and holds the frames with ids first, first + 1, ...
+ */
+bool segmentMatches(const string &path, uint64_t first, uint64_t count) {
+	SegmentReader reader(path);
+	if (reader.Open() != 0 || reader.GetFrameCount() != count) {
+		return false;
+	}
+	for (uint64_t i = 0; i < count; ++i) {
+		if (!frameMatches(reader, i, first + i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t fileSize(const string &path) {
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+vector<char> readFile(const string &path) {
+	vector<char> data(fileSize(path));
+	FILE *file = fopen(path.c_str(), "rb");
+	if (file != NULL) {
+		data.resize(fread(data.data(), 1, data.size(), file));
+		fclose(file);
+	}
+	return data;
+}
+
+void writeFile(const string &path, const vector<char> &data) {
+	FILE *file = fopen(path.c_str(), "wb");
+	if (file != NULL) {
+		fwrite(data.data(), 1, data.size(), file);
+		fclose(file);
+	}
+}
+
+uint64_t frameBytes(int width, int height) {
+	return (sizeof(RawFrameHeader) + (uint64_t) width * height * sizeof(uint16_t) + 7) & ~(uint64_t) 7;
+}
+
+/**
+ * @return segment size that holds the given number of frames
+ */
+uint64_t segmentBytes(int width, int height, uint64_t frames) {
+	return segmentDataOffset + frames * (frameBytes(width, height) + sizeof(SegmentIndexEntry));
+}
+
+/**
+ * Writes 25 frames into segments of 10, reading the first segment while it is written.
+ */
+void checkRoundTrip(const string &directory) {
+	const int width = 32, height = 24;
+	string path = directory + "/trip.seg";
+	{
+		SegmentFrameWriter writer(path, segmentBytes(width, height, 10), width, height);
+		bool written = true;
+		for (uint64_t id = 0; id < 3; ++id) {
+			written = written && writer.Write(makeFrame(id, width, height));
+		}
+		{
+			// Closed again before the writer finishes the segment
+			SegmentReader reader(segmentPath(path, 0));
+			bool live = reader.Open() == 0 && reader.GetFrameCount() == 3 && frameMatches(reader, 2, 2)
+					&& reader.GetIndexEntry(3) == NULL;
+			written = written && writer.Write(makeFrame(3, width, height));
+			live = live && reader.GetFrameCount() == 4 && frameMatches(reader, 3, 3);
+			check(live, "round trip: frames readable while the segment is written");
+		}
+		for (uint64_t id = 4; id < 25; ++id) {
+			written = written && writer.Write(makeFrame(id, width, height));
+		}
+		check(written && writer.GetError() == 0 && writer.GetSegmentCount() == 3, "round trip: 25 frames into 3 segments");
+	}
+	check(segmentMatches(segmentPath(path, 0), 0, 10) && segmentMatches(segmentPath(path, 1), 10, 10)
+			&& segmentMatches(segmentPath(path, 2), 20, 5), "round trip: finished segments read back");
+
+	SegmentReader full(segmentPath(path, 0));
+	SegmentReader partial(segmentPath(path, 2));
+	bool opened = full.Open() == 0 && partial.Open() == 0;
+	uint64_t bytes = frameBytes(width, height);
+	check(opened && full.GetHeader().indexOffset == segmentDataOffset + 10 * bytes
+			&& fileSize(segmentPath(path, 0)) == segmentDataOffset + 10 * (bytes + sizeof(SegmentIndexEntry)),
+			"index: full segment keeps its index after the frames");
+	check(opened && partial.GetHeader().indexOffset == segmentDataOffset + 5 * bytes
+			&& fileSize(segmentPath(path, 2)) == segmentDataOffset + 5 * (bytes + sizeof(SegmentIndexEntry)),
+			"index: partial segment index moved behind its last frame");
+}
+
+/**
+ * Frames smaller than the index entries of the unused frames, the index cannot be moved.
+ */
+void checkIndexInPlace(const string &directory) {
+	const int width = 4, height = 4;
+	string path = directory + "/place.seg";
+	uint64_t bytes = frameBytes(width, height);
+	{
+		SegmentFrameWriter writer(path, segmentBytes(width, height, 10), width, height);
+		for (uint64_t id = 0; id < 9; ++id) {
+			writer.Write(makeFrame(id, width, height));
+		}
+	}
+	SegmentReader reader(segmentPath(path, 0));
+	check(9 * sizeof(SegmentIndexEntry) > bytes && reader.Open() == 0
+			&& reader.GetHeader().indexOffset == segmentDataOffset + 10 * bytes
+			&& fileSize(segmentPath(path, 0)) == segmentDataOffset + 10 * bytes + 9 * sizeof(SegmentIndexEntry)
+			&& segmentMatches(segmentPath(path, 0), 0, 9), "index: left in place where moving it would overlap");
+}
+
+/**
+ * Damages a copy of a finished segment of 5 frames.
+ * @return errno of SegmentReader::Open(), the damaged frame must give no pixels
+ */
+int openCorrupt(const string &directory, const vector<char> &good, void (*damage)(vector<char> &), bool &framesOk) {
+	string path = directory + "/corrupt.seg";
+	vector<char> data = good;
+	damage(data);
+	writeFile(path, data);
+	SegmentReader reader(path);
+	int error = reader.Open();
+	framesOk = error != 0 || (reader.GetPixels(2) == NULL && frameMatches(reader, 1, 1) && frameMatches(reader, 3, 3));
+	return error;
+}
+
+SegmentHeader &headerOf(vector<char> &data) {
+	return *(SegmentHeader *) data.data();
+}
+
+SegmentIndexEntry &entryOf(vector<char> &data, uint64_t i) {
+	return ((SegmentIndexEntry *) (data.data() + headerOf(data).indexOffset))[i];
+}
+
+void checkCorrupt(const string &directory) {
+	const int width = 32, height = 24;
+	string path = directory + "/good.seg";
+	{
+		SegmentFrameWriter writer(path, segmentBytes(width, height, 10), width, height);
+		for (uint64_t id = 0; id < 5; ++id) {
+			writer.Write(makeFrame(id, width, height));
+		}
+	}
+	vector<char> good = readFile(segmentPath(path, 0));
+	bool framesOk = true;
+	bool ok = openCorrupt(directory, good, [](vector<char> &) {}, framesOk) == 0;
+	check(ok, "corrupt: undamaged copy opens");
+	ok = openCorrupt(directory, good, [](vector<char> &d) { d[0] = 'X'; }, framesOk) == EINVAL;
+	ok = ok && openCorrupt(directory, good, [](vector<char> &d) { headerOf(d).version = segmentVersion + 1; },
+			framesOk) == EINVAL;
+	check(ok, "corrupt: wrong magic or newer version rejected");
+	ok = openCorrupt(directory, good, [](vector<char> &d) { headerOf(d).indexOffset = d.size() + 1; }, framesOk)
+			== EINVAL;
+	ok = ok && openCorrupt(directory, good, [](vector<char> &d) { headerOf(d).dataOffset = d.size() + 1; },
+			framesOk) == EINVAL;
+	ok = ok && openCorrupt(directory, good, [](vector<char> &d) { headerOf(d).dataOffset = 8; }, framesOk) == EINVAL;
+	check(ok, "corrupt: data or index outside the file rejected");
+	ok = openCorrupt(directory, good, [](vector<char> &d) { headerOf(d).frameCount = 10; }, framesOk) == EINVAL;
+	ok = ok && openCorrupt(directory, good, [](vector<char> &d) { headerOf(d).frameBytes = 64; }, framesOk)
+			== EINVAL;
+	ok = ok && openCorrupt(directory, good, [](vector<char> &d) { headerOf(d).frameBytes = 0; }, framesOk)
+			== EINVAL;
+	check(ok, "corrupt: frame count or frame size beyond the file rejected");
+	ok = openCorrupt(directory, good, [](vector<char> &d) { d.resize(d.size() / 2); }, framesOk) == EINVAL;
+	ok = ok && openCorrupt(directory, good, [](vector<char> &d) { d.resize(sizeof(SegmentHeader) - 1); },
+			framesOk) == EINVAL;
+	check(ok, "corrupt: truncated file rejected");
+
+	bool entries = openCorrupt(directory, good, [](vector<char> &d) { entryOf(d, 2).offset = d.size() - 8; },
+			framesOk) == 0 && framesOk;
+	entries = entries && openCorrupt(directory, good, [](vector<char> &d) { entryOf(d, 2).offset = 0; },
+			framesOk) == 0 && framesOk;
+	entries = entries && openCorrupt(directory, good, [](vector<char> &d) { entryOf(d, 2).offset = UINT64_MAX; },
+			framesOk) == 0 && framesOk;
+	entries = entries && openCorrupt(directory, good, [](vector<char> &d) {
+		// Points into the pixels of the frame, which do not read as a header of its size
+		entryOf(d, 2).offset += sizeof(RawFrameHeader);
+	}, framesOk) == 0 && framesOk;
+	check(entries, "corrupt: index entry outside the frames gives no frame");
+}
+
+void checkSize(const string &directory) {
+	string path = directory + "/huge.seg";
+	SegmentFrameWriter writer(path, UINT64_MAX, 32, 24);
+	bool failed = !writer.Write(makeFrame(0, 32, 24)) && writer.GetError() == EFBIG;
+	check(failed && !isMappableSegmentSize(UINT64_MAX) && isMappableSegmentSize(defaultSegmentBytes)
+			&& fileSize(segmentPath(path, 0)) == 0, "size: segment beyond the address space fails with EFBIG");
+}
+
+int main() {
+	char directory[] = "/tmp/segment_bench.XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		perror("mkdtemp");
+		return 1;
+	}
+	checkRoundTrip(directory);
+	checkIndexInPlace(directory);
+	checkCorrupt(directory);
+	checkSize(directory);
+
+	string command = string("rm -rf ") + directory;
+	if (system(command.c_str()) != 0) {
+		fprintf(stderr, "Cannot remove %s\n", directory);
+	}
+	return allOk ? 0 : 1;
+}
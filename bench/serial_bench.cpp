@@ -0,0 +1,323 @@
+/**
+ * @file   serial_bench.cpp
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Checks the Tau2 packet codec and batch matching and times batches against single commands.
+ *
+ * Packets are checked against a known encoding from the Tau2 interface description and
+ * decoded back, also cut short, corrupted and behind noise. Tau2Serial then runs against a
+ * simulated camera that answers its commands one after the other, with replies lost, late,
+ * corrupted, swapped or stray, and every answered command must carry its own reply. Last a
+ * camera profile is applied as one batch and as one command at a time.
+ * Exits with a non-zero status if a check fails.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <vector>
+#include "camera_profile.h"
+#include "tau2_serial.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/**
+ * What the simulated camera does with the reply to one command.
+ */
+enum class Reply {
+	Normal,
+	Lost,		//* Never sent
+	Late,		//* Sent after lateMs on top of the processing time
+	Corrupt,	//* Sent with a broken data CRC
+	Swapped,	//* Sent after the reply to the next command
+	Stray		//* Preceded by a reply to a command that was never sent
+};
+
+/**
+ * Camera on the other end of the link: bytes take transitMs each way, and each command is
+ * processed for processingMs after the previous one. Replies echo the arguments.
+ */
+class SimulatedTau2Link : public Tau2SerialLink {
+public:
+	SimulatedTau2Link(double processingMs, double transitMs, double lateMs = 300.0) :
+			processing(Duration(processingMs)), transit(Duration(transitMs)), late(Duration(lateMs)) {
+	}
+
+	/**
+	 * Sets what happens to the replies of the next commands, in order, Normal afterwards.
+	 */
+	void Script(const vector<Reply> &replies) {
+		script.assign(replies.begin(), replies.end());
+	}
+
+	bool Write(const uint8_t *data, size_t size) {
+		input.insert(input.end(), data, data + size);
+		for (;;) {
+			Tau2Packet packet;
+			size_t consumed;
+			Tau2DecodeResult result = tau2DecodePacket(input.data(), input.size(), packet, consumed);
+			if (result == Tau2DecodeResult::Incomplete) {
+				break;
+			}
+			input.erase(input.begin(), input.begin() + consumed);
+			if (result == Tau2DecodeResult::Complete) {
+				Answer(packet);
+			}
+		}
+		return true;
+	}
+
+	size_t ReadAvailable(uint8_t *buffer, size_t size) {
+		size_t n = 0;
+		while (!pending.empty() && pending.front().first <= Clock::now() && n < size) {
+			vector<uint8_t> &bytes = pending.front().second;
+			size_t k = min(size - n, bytes.size());
+			copy(bytes.begin(), bytes.begin() + k, buffer + n);
+			bytes.erase(bytes.begin(), bytes.begin() + k);
+			n += k;
+			if (bytes.empty()) {
+				pending.pop_front();
+			}
+		}
+		return n;
+	}
+
+	void Flush() {
+	}
+
+private:
+	static Clock::duration Duration(double ms) {
+		return chrono::duration_cast<Clock::duration>(chrono::duration<double, milli>(ms));
+	}
+
+	void Answer(const Tau2Packet &packet) {
+		Reply reply = Reply::Normal;
+		if (!script.empty()) {
+			reply = script.front();
+			script.pop_front();
+		}
+		Clock::time_point arrival = Clock::now() + transit;
+		busyUntil = (busyUntil > arrival ? busyUntil : arrival) + processing
+				+ (reply == Reply::Late ? late : Clock::duration(0));
+		Clock::time_point sent = busyUntil + transit;
+
+		vector<uint8_t> bytes;
+		if (reply == Reply::Stray) {
+			tau2EncodePacket(Tau2Function::CAMERA_PART, vector<uint8_t>(), bytes);
+		}
+		tau2EncodePacket(packet.function, packet.data, bytes);
+		if (reply == Reply::Corrupt) {
+			bytes.back() ^= 0x01;
+		}
+		if (reply == Reply::Lost) {
+			return;
+		}
+		if (swapped) {
+			// The reply held back goes out after this one
+			pending.push_back(make_pair(sent, bytes));
+			pending.push_back(make_pair(sent, heldBack));
+			swapped = false;
+		} else if (reply == Reply::Swapped) {
+			heldBack = bytes;
+			swapped = true;
+		} else {
+			pending.push_back(make_pair(sent, bytes));
+		}
+	}
+
+	Clock::duration processing;
+	Clock::duration transit;
+	Clock::duration late;
+	Clock::time_point busyUntil;
+	deque<Reply> script;
+	vector<uint8_t> input;
+	deque<pair<Clock::time_point, vector<uint8_t> > > pending;	//* Replies and when they arrive
+	vector<uint8_t> heldBack;
+	bool swapped = false;
+};
+
+static bool allPassed = true;
+
+void check(bool passed, const char *what) {
+	printf("%-60s %s\n", what, passed ? "ok" : "FAILED");
+	allPassed &= passed;
+}
+
+/**
+ * Commands with distinct arguments, functions repeating so they can be confused.
+ */
+vector<Tau2Command> numberedCommands(size_t count) {
+	const Tau2Function functions[] = { Tau2Function::CONTRAST, Tau2Function::BRIGHTNESS, Tau2Function::AGC_TYPE };
+	vector<Tau2Command> commands;
+	for (size_t i = 0; i < count; ++i) {
+		commands.push_back(Tau2Command(functions[i % 3], tau2Word(0x100 + i)));
+	}
+	return commands;
+}
+
+/**
+ * @return true if every answered command carries its own arguments back and the
+ *         answered ones are exactly those expected
+ */
+bool repliesMatch(const vector<Tau2Command> &commands, const vector<bool> &answered) {
+	for (size_t i = 0; i < commands.size(); ++i) {
+		if (commands[i].answered != answered[i]) {
+			return false;
+		}
+		if (commands[i].answered && (commands[i].status != Tau2Status::CAM_OK || commands[i].response != commands[i].data)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void checkPackets() {
+	// GET_REVISION as given in the Tau2 interface description, and a command with an argument
+	const uint8_t revision[] = { 0x6E, 0x00, 0x00, 0x05, 0x00, 0x00, 0x34, 0x4B, 0x00, 0x00 };
+	const uint8_t agcType[] = { 0x6E, 0x00, 0x00, 0x13, 0x00, 0x02, 0xE5, 0xCA, 0x00, 0x01, 0x10, 0x21 };
+	vector<uint8_t> bytes;
+	tau2EncodePacket(Tau2Function::GET_REVISION, vector<uint8_t>(), bytes);
+	check(bytes == vector<uint8_t>(revision, revision + sizeof(revision)), "encode GET_REVISION");
+	bytes.clear();
+	tau2EncodePacket(Tau2Function::AGC_TYPE, tau2Word(1), bytes);
+	check(bytes == vector<uint8_t>(agcType, agcType + sizeof(agcType)), "encode AGC_TYPE 1");
+
+	Tau2Packet packet;
+	size_t consumed;
+	check(tau2DecodePacket(agcType, sizeof(agcType), packet, consumed) == Tau2DecodeResult::Complete
+			&& consumed == sizeof(agcType) && packet.function == Tau2Function::AGC_TYPE
+			&& tau2ReadWord(packet.data) == 1, "decode AGC_TYPE 1");
+	bool incomplete = true;
+	for (size_t size = 0; size < sizeof(agcType); ++size) {
+		incomplete &= tau2DecodePacket(agcType, size, packet, consumed) == Tau2DecodeResult::Incomplete;
+	}
+	check(incomplete, "decode every truncated packet as incomplete");
+
+	vector<uint8_t> corrupt(agcType, agcType + sizeof(agcType));
+	corrupt[3] ^= 0x01;
+	check(tau2DecodePacket(corrupt.data(), corrupt.size(), packet, consumed) == Tau2DecodeResult::Invalid,
+			"reject a broken header CRC");
+	corrupt.assign(agcType, agcType + sizeof(agcType));
+	corrupt[9] ^= 0x01;
+	check(tau2DecodePacket(corrupt.data(), corrupt.size(), packet, consumed) == Tau2DecodeResult::Invalid,
+			"reject a broken data CRC");
+
+	vector<uint8_t> noisy = { 0x00, 0x6E, 0xFF };
+	noisy.insert(noisy.end(), revision, revision + sizeof(revision));
+	size_t offset = 0;
+	Tau2DecodeResult result;
+	while ((result = tau2DecodePacket(noisy.data() + offset, noisy.size() - offset, packet, consumed))
+			== Tau2DecodeResult::Invalid) {
+		offset += consumed;
+	}
+	check(result == Tau2DecodeResult::Complete && offset == 3 && packet.function == Tau2Function::GET_REVISION,
+			"find a packet behind noise");
+}
+
+void checkMatching() {
+	SimulatedTau2Link link(1.0, 0.5, 200.0);
+	Tau2Serial serial(link, 4);
+	vector<Tau2Command> commands = numberedCommands(8);
+	vector<bool> all(8, true);
+
+	check(serial.Execute(commands) && repliesMatch(commands, all), "answer a batch in order");
+
+	// Round trips are measured on single commands, the timeouts are a few ms from now on
+	bool single = true;
+	for (const Tau2Command &command : numberedCommands(3)) {
+		vector<uint8_t> response;
+		single &= serial.Transact(command.function, command.data, response) == Tau2Status::CAM_OK
+				&& response == command.data;
+	}
+	check(single, "answer single commands");
+
+	// The queue behind the first command must not expire
+	commands = numberedCommands(12);
+	check(serial.Execute(commands) && repliesMatch(commands, vector<bool>(12, true)),
+			"time queued commands from the reply before them");
+
+	vector<bool> answered = all;
+	answered[2] = false;
+	link.Script({ Reply::Normal, Reply::Normal, Reply::Lost });
+	commands = numberedCommands(8);
+	check(!serial.Execute(commands) && repliesMatch(commands, answered), "give up on a lost reply");
+
+	answered = all;
+	answered[4] = false;
+	link.Script({ Reply::Normal, Reply::Normal, Reply::Normal, Reply::Normal, Reply::Corrupt });
+	commands = numberedCommands(8);
+	check(!serial.Execute(commands) && repliesMatch(commands, answered), "drop a reply with a broken CRC");
+
+	link.Script({ Reply::Normal, Reply::Stray });
+	commands = numberedCommands(8);
+	check(serial.Execute(commands) && repliesMatch(commands, all), "ignore a stray reply");
+
+	// The reply to 3 overtakes the one to 2, which then counts as lost and is not taken for a later command
+	answered = all;
+	answered[2] = false;
+	link.Script({ Reply::Normal, Reply::Normal, Reply::Swapped });
+	commands = numberedCommands(8);
+	check(!serial.Execute(commands) && repliesMatch(commands, answered), "match replies out of order by sequence");
+
+	// A late reply must be dropped, also when it only arrives during the next batch
+	link.Script({ Reply::Normal, Reply::Late });
+	commands = numberedCommands(2);
+	check(!serial.Execute(commands) && repliesMatch(commands, vector<bool>{ true, false }), "time out a late reply");
+	commands = numberedCommands(8);
+	serial.Execute(commands);
+	bool ownReplies = true;
+	for (const Tau2Command &command : commands) {
+		ownReplies &= !command.answered || command.response == command.data;
+	}
+	check(ownReplies, "drop the late reply in the next batch");
+	commands = numberedCommands(8);
+	check(serial.Execute(commands) && repliesMatch(commands, all), "answer a batch after recovering");
+}
+
+/**
+ * Applies the profile as one batch and as one command at a time.
+ */
+void timeProfile(double processingMs, double transitMs) {
+	vector<CameraProfileSetting> profile;
+	const char *lines[] = { "agc_type 1", "contrast 32", "brightness 8192", "brightness_bias 0", "palette 0",
+			"orientation 0", "ffc_mode 0", "ffc_period 0", "ffc_temp_delta 50", "dde_gain 17",
+			"plateau_level 250", "agc_midpoint 127", "max_agc_gain 12", "isotherm 0" };
+	for (const char *line : lines) {
+		parseCameraProfileLine(line, profile);
+	}
+
+	SimulatedTau2Link link(processingMs, transitMs);
+	Tau2Serial serial(link, 4);
+	vector<Tau2Command> commands = cameraProfileCommands(profile);
+	Clock::time_point start = Clock::now();
+	bool batched = serial.Execute(commands);
+	double batchMs = chrono::duration<double, milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	bool single = true;
+	for (const Tau2Command &command : cameraProfileCommands(profile)) {
+		vector<uint8_t> response;
+		single &= serial.Transact(command.function, command.data, response) == Tau2Status::CAM_OK;
+	}
+	double singleMs = chrono::duration<double, milli>(Clock::now() - start).count();
+	printf("%-10zu %10.1f %10.1f %10.1f %10.1f\n", profile.size(), processingMs, transitMs, singleMs, batchMs);
+	allPassed &= batched && single;
+}
+
+int main() {
+	checkPackets();
+	checkMatching();
+
+	printf("\n%-10s %10s %10s %10s %10s\n", "settings", "camera ms", "link ms", "single ms", "batch ms");
+	timeProfile(0.5, 2.0);
+	timeProfile(2.0, 2.0);
+	timeProfile(2.0, 10.0);
+
+	if (!allPassed) {
+		printf("Serial protocol checks failed\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file   temperature_bench.cpp
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Times TemperatureLut frame conversion against per pixel evaluation on a synthetic 640x512 frame.
+ *
+ * The SDK formula lives in the WIC SDK binary, so a Planck style stand-in with the same
+ * kind of double precision transcendental math is used for the per pixel path.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "temperature_lut.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static const int width = 640;
+static const int height = 512;
+
+/**
+ * Planck style raw to temperature conversion with atmospheric and reflected corrections.
+ */
+double planckTemperatureC(uint16_t raw, const RadiometricParameterSet &p) {
+	const double R = 366545.0, B = 1428.0, F = 1.0, O = -342.0;
+	double tau = exp(-sqrt(p.distance) * (0.006569 + 0.01262 * p.humidity));
+	double reflected = R / (exp(B / (p.reflectedTemperatureC + 273.15)) - F) - O;
+	double atmosphere = R / (exp(B / (p.atmosphericTemperatureC + 273.15)) - F) - O;
+	double object = (raw - (1.0 - p.emissivity) * tau * reflected - (1.0 - tau) * atmosphere) / (p.emissivity * tau);
+	return B / log(R / (object + O) + F) - 273.15;
+}
+
+int main() {
+	RadiometricParameterSet params;
+	params.emissivity = 0.95;
+	params.reflectedTemperatureC = 20.0;
+	params.atmosphericTemperatureC = 20.0;
+	params.humidity = 0.5;
+	params.distance = 1.0;
+
+	vector<uint16_t> raw(width * height);
+	vector<float> celsius(raw.size());
+	for (size_t i = 0; i < raw.size(); ++i) {
+		raw[i] = 7000 + (i * 7919) % 4000;
+	}
+
+	const int frames = 20;
+	volatile double sink = 0.0;
+
+	Clock::time_point start = Clock::now();
+	for (int f = 0; f < frames; ++f) {
+		for (size_t i = 0; i < raw.size(); ++i) {
+			celsius[i] = (float) planckTemperatureC(raw[i], params);
+		}
+		sink = sink + celsius[f];
+	}
+	double perPixelMs = chrono::duration<double, milli>(Clock::now() - start).count() / frames;
+
+	start = Clock::now();
+	TemperatureLut lut;
+	lut.Build(params, 1, [&params](uint16_t r) { return planckTemperatureC(r, params); });
+	double buildMs = chrono::duration<double, milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (int f = 0; f < frames * 10; ++f) {
+		lut.Convert(raw.data(), celsius.data(), celsius.size());
+		sink = sink + celsius[f];
+	}
+	double lutMs = chrono::duration<double, milli>(Clock::now() - start).count() / (frames * 10);
+
+	printf("%-24s %12s\n", "conversion", "ms/frame");
+	printf("%-24s %12.3f\n", "per pixel formula", perPixelMs);
+	printf("%-24s %12.3f\n", "TemperatureLut", lutMs);
+	printf("%-24s %12.3f\n", "table build (once)", buildMs);
+	return 0;
+}
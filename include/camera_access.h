@@ -0,0 +1,63 @@
+/**
+ * @file   camera_access.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Access to the Pleora objects held privately by the WIC SDK Camera class.
+ *
+ * The WIC SDK is only shipped as a binary, so Camera cannot be extended. Its members are
+ * reached through pointers-to-member formed in explicit template instantiations, where
+ * access checking does not apply. Only the declared layout in Camera.h is relied upon.
+ */
+
+#ifndef CAMERA_ACCESS_H
+#define CAMERA_ACCESS_H
+
+#include "Camera.h"
+
+template <typename Tag, typename Tag::type Member>
+struct CameraMemberAccess {
+	friend typename Tag::type cameraMember(Tag) {
+		return Member;
+	}
+};
+
+struct CameraBufferTag {
+	typedef PvBuffer *Camera::*type;
+	friend type cameraMember(CameraBufferTag);
+};
+template struct CameraMemberAccess<CameraBufferTag, &Camera::lBuffer>;
+
+struct CameraPipelineTag {
+	typedef PvPipeline *Camera::*type;
+	friend type cameraMember(CameraPipelineTag);
+};
+template struct CameraMemberAccess<CameraPipelineTag, &Camera::mPipeline>;
+
+struct CameraStreamTag {
+	typedef PvStream *Camera::*type;
+	friend type cameraMember(CameraStreamTag);
+};
+template struct CameraMemberAccess<CameraStreamTag, &Camera::mStream>;
+
+/**
+ * @return the PvBuffer handed out by the last Camera::RetreiveBuffer() call
+ */
+PvBuffer *GetCurrentPvBuffer(Camera *cam) {
+	return cam->*cameraMember(CameraBufferTag());
+}
+
+/**
+ * @return the pipeline the camera acquires into, NULL while not connected
+ */
+PvPipeline *GetPvPipeline(Camera *cam) {
+	return cam->*cameraMember(CameraPipelineTag());
+}
+
+/**
+ * @return the GigE Vision or USB3 Vision stream of the camera, NULL while not connected
+ */
+PvStream *GetPvStream(Camera *cam) {
+	return cam->*cameraMember(CameraStreamTag());
+}
+
+#endif /* CAMERA_ACCESS_H */
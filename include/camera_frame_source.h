@@ -0,0 +1,309 @@
+/**
+ * @file   camera_frame_source.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  FrameSource backed by a connected WIC camera.
+ */
+
+#ifndef CAMERA_FRAME_SOURCE_H
+#define CAMERA_FRAME_SOURCE_H
+
+#include <memory>
+#include "Camera.h"
+#include "camera_access.h"
+#include "camera_telemetry.h"
+#include "frame_source.h"
+#include "radiometry_settings.h"
+#include "tau2_serial.h"
+
+/**
+ * Nominal frame rate of the camera in Hz.
+ */
+double cameraSpeedHz(CameraSerialSettings::CameraSpeed speed) {
+	switch (speed) {
+	case CameraSerialSettings::CameraSpeed::_9Hz:
+		return 9.0;
+	case CameraSerialSettings::CameraSpeed::_30Hz:
+		return 30.0;
+	case CameraSerialSettings::CameraSpeed::_60Hz:
+		return 60.0;
+	default:
+		return 0.0;
+	}
+}
+
+class CameraFrameSource : public FrameSource {
+public:
+	/**
+	 * Reads the static camera properties once, the camera must be connected.
+	 * @param telemetryMaxAgeS age in seconds after which temperatures are read from the camera again
+	 */
+	CameraFrameSource(Camera *cam, double telemetryMaxAgeS = 1.0) : cam(cam),
+			telemetry(cam, telemetryMaxAgeS), radiometry(cam, telemetry.GetSerialMutex()) {
+	}
+
+	int GetResolutionX() {
+		return telemetry.GetInfo().resolutionX;
+	}
+
+	int GetResolutionY() {
+		return telemetry.GetInfo().resolutionY;
+	}
+
+	double GetCameraSpeedHz() {
+		return cameraSpeedHz(telemetry.GetInfo().cameraSpeed);
+	}
+
+	double GetSensorTemperature() {
+		return telemetry.Get().sensorTemperatureC;
+	}
+
+	double GetHousingTemperature() {
+		return telemetry.Get().housingTemperatureC;
+	}
+
+	double GetShutterTemperature() {
+		return telemetry.Get().shutterTemperatureC;
+	}
+
+	void GetTemperatures(double &sensorC, double &housingC, double &shutterC, bool refresh) {
+		CameraTelemetrySnapshot snapshot = refresh ? telemetry.Refresh() : telemetry.Get();
+		sensorC = snapshot.sensorTemperatureC;
+		housingC = snapshot.housingTemperatureC;
+		shutterC = snapshot.shutterTemperatureC;
+	}
+
+	double GetSerialRoundTripS() {
+		return telemetry.GetSerialRoundTripS();
+	}
+
+	/**
+	 * Radiometric parameters have to be changed through this object to keep tables current.
+	 */
+	RadiometrySettings &GetRadiometry() {
+		return radiometry;
+	}
+
+	/**
+	 * Sets up the PvPipeline the SDK created at connect.
+	 */
+	bool ConfigurePipeline(const PipelineOptions &options) {
+		PvPipeline *pipeline = GetPvPipeline(cam);
+		if (pipeline == NULL) {
+			return false;
+		}
+		if (options.bufferSize > 0) {
+			// SetBufferSize() reports nothing, the size it kept tells whether it took effect
+			pipeline->SetBufferSize(options.bufferSize);
+			if (pipeline->GetBufferSize() != options.bufferSize) {
+				return false;
+			}
+		}
+		if (options.bufferCount > 0 && !pipeline->SetBufferCount(options.bufferCount).IsOK()) {
+			return false;
+		}
+		return options.threadPriority < 0
+				|| pipeline->SetBufferHandlingThreadPriority(options.threadPriority).IsOK();
+	}
+
+	uint32_t GetPipelineBufferCount() {
+		PvPipeline *pipeline = GetPvPipeline(cam);
+		return pipeline != NULL ? pipeline->GetBufferCount() : 0;
+	}
+
+	bool SetPipelineBufferCount(uint32_t count) {
+		PvPipeline *pipeline = GetPvPipeline(cam);
+		return pipeline != NULL && pipeline->SetBufferCount(count).IsOK();
+	}
+
+	/**
+	 * Reads the statistics the stream object keeps on the host, such as block, resend and
+	 * lost packet counts and bandwidth. Which ones exist depends on the transport, so all
+	 * read-only integer and float stream parameters are reported. They are looked up once
+	 * per stream; reading them is local to the host and sends nothing to the camera.
+	 */
+	bool ReadTransportStatistics(TransportStatistics &statistics) {
+		lock_guard<mutex> lock(transportMutex);
+		PvStream *stream = GetPvStream(cam);
+		if (stream == NULL) {
+			return false;
+		}
+		if (stream != transportStream) {
+			FindTransportStatistics(stream);
+		}
+		if (transportParameters.empty()) {
+			return false;
+		}
+
+		switch (stream->GetType()) {
+		case PvStreamTypeGEV:
+			statistics.transport = "GEV";
+			break;
+		case PvStreamTypeU3V:
+			statistics.transport = "U3V";
+			break;
+		default:
+			statistics.transport = "unknown";
+		}
+		statistics.values.clear();
+		for (PvGenParameter *parameter : transportParameters) {
+			PvGenType type;
+			int64_t integer;
+			double real;
+			parameter->GetType(type);
+			if (type == PvGenTypeInteger && static_cast<PvGenInteger *>(parameter)->GetValue(integer).IsOK()) {
+				statistics.values.push_back(make_pair(string(parameter->GetName().GetAscii()), (double) integer));
+			} else if (type == PvGenTypeFloat && static_cast<PvGenFloat *>(parameter)->GetValue(real).IsOK()) {
+				statistics.values.push_back(make_pair(string(parameter->GetName().GetAscii()), real));
+			}
+		}
+		return true;
+	}
+
+	void StartAcquisition() {
+		cam->StartAcquisition();
+	}
+
+	bool IsAcquiring() {
+		return cam->IsAcquiring();
+	}
+
+	const uint16_t *RetreiveBuffer() {
+		return (const uint16_t *) cam->RetreiveBuffer();
+	}
+
+	uint64_t GetBufferTimestamp() {
+		return GetCurrentPvBuffer(cam)->GetTimestamp();
+	}
+
+	uint64_t GetBufferBlockId() {
+		return GetCurrentPvBuffer(cam)->GetBlockID();
+	}
+
+	/**
+	 * @return frameFlag... bits for an incomplete transfer of the current frame, a buffer
+	 * without an image counts as a transfer error
+	 */
+	uint32_t GetBufferFlags() {
+		PvBuffer *buffer = GetCurrentPvBuffer(cam);
+		PvImage *image = buffer->GetImage();
+		uint32_t flags = 0;
+		if (!buffer->GetOperationResult().IsOK()) {
+			flags |= frameFlagTransferError;
+		}
+		if (image == NULL) {
+			return flags | frameFlagTransferError;
+		}
+		if (image->IsPartialLineMissing()) {
+			flags |= frameFlagPartialLineMissing;
+		}
+		if (image->IsFullLineMissing()) {
+			flags |= frameFlagFullLineMissing;
+		}
+		return flags;
+	}
+
+	void ReleaseBuffer() {
+		cam->ReleaseBuffer();
+	}
+
+	void StopAcquisition() {
+		cam->StopAcquisition();
+	}
+
+	/**
+	 * Switching to manual saves the FFC mode of the telemetry snapshot, which may have
+	 * been set by a profile, and switching back restores it.
+	 */
+	bool SetManualFFC(bool manual) {
+		CameraSerialSettings::FFCModes mode = telemetry.Get().ffcMode;
+		lock_guard<mutex> lock(telemetry.GetSerialMutex());
+		if (manual && !manualFFC) {
+			savedFFCMode = mode;
+		}
+		if (manual || manualFFC) {
+			cam->GetSettings()->SetFFCMode(manual ? CameraSerialSettings::FFCModes::Manual : savedFFCMode);
+			manualFFC = manual;
+		}
+		return true;
+	}
+
+	/**
+	 * Triggers the FFC and waits for the shutter to open again, or one second where the
+	 * shutter position cannot be read.
+	 */
+	bool PerformFFC() {
+		lock_guard<mutex> lock(telemetry.GetSerialMutex());
+		cam->GetSettings()->DoFFC();
+
+		Tau2Serial *serial = GetTau2Serial();
+		if (serial == NULL || !tau2WaitForFFC(*serial)) {
+			sleep(1);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Sends the commands as one pipelined batch, see Tau2Serial::Execute().
+	 * @return true if every command was answered with CAM_OK
+	 */
+	bool ExecuteSerial(vector<Tau2Command> &commands) {
+		lock_guard<mutex> lock(telemetry.GetSerialMutex());
+		Tau2Serial *serial = GetTau2Serial();
+		return serial != NULL && serial->Execute(commands);
+	}
+
+	/**
+	 * Pipelined access to the camera's serial port, shared with the telemetry. The
+	 * telemetry serial mutex must be held while it is used.
+	 * @return NULL if the port cannot be opened
+	 */
+	Tau2Serial *GetTau2Serial() {
+		return telemetry.GetTau2Serial();
+	}
+
+	/**
+	 * Sets how the camera takes part in hardware frame synchronization.
+	 */
+	void SetExternalSync(CameraSerialSettings::ExternalSyncModes mode) {
+		lock_guard<mutex> lock(telemetry.GetSerialMutex());
+		cam->GetSettings()->SetExternalSync(mode);
+	}
+
+	Camera *GetCamera() {
+		return cam;
+	}
+
+	CameraTelemetry &GetTelemetry() {
+		return telemetry;
+	}
+
+private:
+	void FindTransportStatistics(PvStream *stream) {
+		PvGenParameterArray *parameters = stream->GetParameters();
+
+		transportStream = stream;
+		transportParameters.clear();
+		for (uint32_t i = 0; parameters != NULL && i < parameters->GetCount(); ++i) {
+			PvGenParameter *parameter = parameters->Get(i);
+			PvGenType type;
+			if (parameter != NULL && parameter->GetType(type).IsOK()
+					&& (type == PvGenTypeInteger || type == PvGenTypeFloat)
+					&& parameter->IsReadable() && !parameter->IsWritable()) {
+				transportParameters.push_back(parameter);
+			}
+		}
+	}
+
+	Camera *cam;
+	CameraTelemetry telemetry;
+	RadiometrySettings radiometry;
+	bool manualFFC = false;				//* Switched to manual by SetManualFFC()
+	CameraSerialSettings::FFCModes savedFFCMode = CameraSerialSettings::FFCModes::Auto;	//* Mode before that
+	mutex transportMutex;				//* Guards the statistics parameters
+	PvStream *transportStream = NULL;		//* Stream the parameters were looked up on
+	vector<PvGenParameter *> transportParameters;
+};
+
+#endif /* CAMERA_FRAME_SOURCE_H */
@@ -0,0 +1,137 @@
+/**
+ * @file   camera_profile.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Camera configuration profiles applied as one serial command batch.
+ *
+ * A profile is a text file with one "setting value" pair per line, where # starts a
+ * comment, e.g.
+ *   agc_type 1		# plateau
+ *   contrast 32
+ *   ffc_mode 1		# automatic
+ *   ffc_period 0x0E10
+ * Every setting is a Tau2 command with a single 16 bit argument, values are decimal or
+ * 0x hexadecimal. The settings are sent in file order through Tau2Serial::Execute(), so
+ * reconfiguring a camera between measurement runs costs a few round trips instead of a
+ * fixed sleep per setting. Radiometric parameters are converted by the SDK and stay with
+ * RadiometrySettings.
+ */
+
+#ifndef CAMERA_PROFILE_H
+#define CAMERA_PROFILE_H
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "tau2_serial.h"
+
+/**
+ * One line of a profile.
+ */
+struct CameraProfileSetting {
+	std::string name;
+	Tau2Function function;
+	uint16_t value;
+};
+
+/**
+ * Setting names of a profile and the commands setting them.
+ */
+static const struct {
+	const char *name;
+	Tau2Function function;
+} cameraProfileFunctions[] = {
+	{ "gain_mode", Tau2Function::GAIN_MODE },
+	{ "ffc_mode", Tau2Function::FFC_MODE_SELECT },
+	{ "ffc_period", Tau2Function::FFC_PERIOD },
+	{ "ffc_temp_delta", Tau2Function::FFC_TEMP_DELTA },
+	{ "video_mode", Tau2Function::VIDEO_MODE },
+	{ "palette", Tau2Function::VIDEO_PALETTE },
+	{ "orientation", Tau2Function::VIDEO_ORIENTATION },
+	{ "agc_type", Tau2Function::AGC_TYPE },
+	{ "contrast", Tau2Function::CONTRAST },
+	{ "brightness", Tau2Function::BRIGHTNESS },
+	{ "brightness_bias", Tau2Function::BRIGHTNESS_BIAS },
+	{ "spot_meter_mode", Tau2Function::SPOT_METER_MODE },
+	{ "isotherm", Tau2Function::ISOTHERM },
+	{ "test_pattern", Tau2Function::TEST_PATTERN },
+	{ "color_mode", Tau2Function::VIDEO_COLOR_MODE },
+	{ "spot_display", Tau2Function::SPOT_DISPLAY },
+	{ "dde_gain", Tau2Function::DDE_GAIN },
+	{ "agc_filter", Tau2Function::AGC_FILTER },
+	{ "plateau_level", Tau2Function::PLATEAU_LEVEL },
+	{ "agc_midpoint", Tau2Function::AGC_MIDPOINT },
+	{ "max_agc_gain", Tau2Function::MAX_AGC_GAIN },
+	{ "dde_threshold", Tau2Function::DDE_THRESHOLD },
+	{ "spatial_threshold", Tau2Function::SPATIAL_THRESHOLD }
+};
+
+/**
+ * Parses one profile line, which may be blank or a comment only.
+ * @return false if the line is invalid
+ */
+inline bool parseCameraProfileLine(const std::string &line, std::vector<CameraProfileSetting> &settings) {
+	std::string text = line.substr(0, line.find('#'));
+	char name[32];
+	char value[32];
+	char rest;
+	int fields = sscanf(text.c_str(), "%31s %31s %c", name, value, &rest);
+	if (fields <= 0) {
+		return true;
+	}
+	if (fields != 2) {
+		return false;
+	}
+
+	char *end;
+	errno = 0;
+	unsigned long number = strtoul(value, &end, 0);
+	if (*end != '\0' || errno != 0 || number > 0xFFFF || value[0] == '-') {
+		return false;
+	}
+	for (const auto &entry : cameraProfileFunctions) {
+		if (strcmp(entry.name, name) == 0) {
+			settings.push_back(CameraProfileSetting{ name, entry.function, (uint16_t) number });
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Reads a profile, adding its settings in file order.
+ * @return 0 on success, the number of the first invalid line, or -1 with errno set if the
+ *         file cannot be read
+ */
+inline int loadCameraProfile(const std::string &path, std::vector<CameraProfileSetting> &settings) {
+	std::ifstream in(path.c_str());
+	if (!in) {
+		return -1;
+	}
+	std::string line;
+	int number = 0;
+	while (std::getline(in, line)) {
+		++number;
+		if (!parseCameraProfileLine(line, settings)) {
+			return number;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @return the batch applying the settings
+ */
+inline std::vector<Tau2Command> cameraProfileCommands(const std::vector<CameraProfileSetting> &settings) {
+	std::vector<Tau2Command> commands;
+	for (const CameraProfileSetting &setting : settings) {
+		commands.push_back(Tau2Command(setting.function, tau2Word(setting.value)));
+	}
+	return commands;
+}
+
+#endif /* CAMERA_PROFILE_H */
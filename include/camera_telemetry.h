@@ -0,0 +1,229 @@
+/**
+ * @file   camera_telemetry.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Cached camera properties and temperatures.
+ *
+ * Every CameraSerialSettings getter is a serial command over the Pleora bridge that blocks
+ * for several milliseconds. CameraTelemetry reads the properties that cannot change while
+ * connected once, and keeps the temperatures and FFC mode in a snapshot that is only read
+ * again from the camera once it is older than a configurable bound. The snapshot is read as
+ * one pipelined Tau2Serial batch with measured timeouts, through the camera's serial port
+ * that CameraTelemetry opens once and keeps; the SDK getters with their fixed waits are
+ * only used when that port cannot be opened or the batch fails.
+ */
+
+#ifndef CAMERA_TELEMETRY_H
+#define CAMERA_TELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Camera.h"
+#include "tau2_serial.h"
+
+/**
+ * Camera properties read once at connect.
+ */
+struct CameraInfo {
+	std::string partNumber;			//* WIC part number
+	std::string cameraPartNumber;
+	std::string model;
+	std::string manufacturer;
+	int cameraSerialNumber = 0;
+	int sensorSerialNumber = 0;
+	int resolutionX = 0;
+	int resolutionY = 0;
+	int fwMajorVersion = 0;
+	int fwMinorVersion = 0;
+	int swMajorVersion = 0;
+	int swMinorVersion = 0;
+	CameraSerialSettings::CameraSpeed cameraSpeed = CameraSerialSettings::CameraSpeed::_30Hz;
+	bool isRadiometric = false;
+	bool radiometryMode = false;		//* Radiometry mode at connect
+	CameraSerialSettings::TestPatterns testPattern = CameraSerialSettings::TestPatterns::Off;
+};
+
+/**
+ * Values that change while the camera runs.
+ */
+struct CameraTelemetrySnapshot {
+	double sensorTemperatureC = 0.0;
+	double housingTemperatureC = 0.0;
+	double shutterTemperatureC = 0.0;
+	CameraSerialSettings::FFCModes ffcMode = CameraSerialSettings::FFCModes::Auto;
+	std::chrono::steady_clock::time_point updated;	//* When the values were read from the camera
+};
+
+class CameraTelemetry {
+public:
+	/**
+	 * Reads the static properties and a first snapshot, the camera must be connected.
+	 * @param maxAgeS age in seconds after which Get() reads the snapshot again
+	 */
+	CameraTelemetry(Camera *cam, double maxAgeS = 1.0) : cam(cam) {
+		SetMaxAge(maxAgeS);
+		Reread();
+	}
+
+	const CameraInfo &GetInfo() const {
+		return info;
+	}
+
+	/**
+	 * Reads the static properties and the snapshot again, e.g. after settings were changed
+	 * on the camera. Not to be called while another thread uses GetInfo().
+	 */
+	void Reread() {
+		lock_guard<mutex> lock(serialMutex);
+		CameraSerialSettings *settings = cam->GetSettings();
+
+		info.partNumber = settings->GetPartNumber();
+		info.cameraPartNumber = settings->GetCameraPartNumber();
+		info.model = settings->GetModel();
+		info.manufacturer = settings->GetManufacturer();
+		info.cameraSerialNumber = settings->GetCameraSerialNumber();
+		info.sensorSerialNumber = settings->GetSensorSerialNumber();
+		info.resolutionX = settings->GetResolutionX();
+		info.resolutionY = settings->GetResolutionY();
+		info.fwMajorVersion = settings->GetFWMajorVersion();
+		info.fwMinorVersion = settings->GetFWMinorVersion();
+		info.swMajorVersion = settings->GetSWMajorVersion();
+		info.swMinorVersion = settings->GetSWMinorVersion();
+		info.cameraSpeed = settings->GetCameraSpeed();
+		info.isRadiometric = settings->GetIsRadiometric();
+		info.radiometryMode = info.isRadiometric && settings->GetRadiometryMode();
+		info.testPattern = settings->GetTestPattern();
+		Read();
+	}
+
+	/**
+	 * @return the snapshot, read from the camera first if it is older than the bound
+	 */
+	CameraTelemetrySnapshot Get() {
+		lock_guard<mutex> lock(serialMutex);
+		if (std::chrono::steady_clock::now() - snapshot.updated > maxAge) {
+			Read();
+		}
+		return snapshot;
+	}
+
+	/**
+	 * @return the snapshot as last read, never talks to the camera
+	 */
+	CameraTelemetrySnapshot GetCached() {
+		lock_guard<mutex> lock(serialMutex);
+		return snapshot;
+	}
+
+	/**
+	 * Reads the snapshot from the camera regardless of its age.
+	 */
+	CameraTelemetrySnapshot Refresh() {
+		lock_guard<mutex> lock(serialMutex);
+		Read();
+		return snapshot;
+	}
+
+	/**
+	 * Lock to hold around other serial commands issued while the telemetry is in use.
+	 */
+	mutex &GetSerialMutex() {
+		return serialMutex;
+	}
+
+	/**
+	 * Pipelined access to the camera's serial port, opened on first use and kept for the
+	 * lifetime of the telemetry. The serial mutex must be held while it is used.
+	 * @return NULL if the port cannot be opened
+	 */
+	Tau2Serial *GetTau2Serial() {
+		if (!serialLink) {
+			serialLink.reset(new PvSerialLink(cam->GetSettings()));
+			serial.reset(new Tau2Serial(*serialLink));
+		}
+		return serialLink->IsOpened() ? serial.get() : NULL;
+	}
+
+	/**
+	 * @return smoothed time of one serial command during the snapshot reads [s], NAN before
+	 * the first read. Does not wait for serial commands in progress, e.g. an FFC.
+	 */
+	double GetSerialRoundTripS() const {
+		return serialRoundTripS.load(std::memory_order_relaxed);
+	}
+
+	void SetMaxAge(double maxAgeS) {
+		lock_guard<mutex> lock(serialMutex);
+		maxAge = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(maxAgeS));
+	}
+
+private:
+	void Read() {
+		static const int readCommands = 4;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		if (!ReadPipelined()) {
+			CameraSerialSettings *settings = cam->GetSettings();
+			snapshot.sensorTemperatureC = settings->GetSensorTemperature();
+			snapshot.housingTemperatureC = settings->GetHousingTemperature();
+			snapshot.shutterTemperatureC = settings->GetShutterTemperature();
+			snapshot.ffcMode = settings->GetFFCMode();
+		}
+		snapshot.updated = std::chrono::steady_clock::now();
+
+		double roundTripS = std::chrono::duration<double>(snapshot.updated - start).count() / readCommands;
+		double average = serialRoundTripS.load(std::memory_order_relaxed);
+		average = std::isnan(average) ? roundTripS : 0.875 * average + 0.125 * roundTripS;
+		serialRoundTripS.store(average, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Reads the snapshot with the commands and scaling of the SDK getters: READ_SENSOR with
+	 * argument 0 gives the sensor in 0.1 °C, with argument 0x0A the housing in 0.01 °C,
+	 * SHUTTER_TEMP the shutter in 0.01 °C. The words are taken as signed, so temperatures
+	 * below 0 °C do not wrap around as in the SDK.
+	 * @return false, leaving the snapshot unchanged, if a command was not answered
+	 */
+	bool ReadPipelined() {
+		Tau2Serial *serial = GetTau2Serial();
+		if (serial == NULL) {
+			return false;
+		}
+		std::vector<Tau2Command> commands;
+		commands.push_back(Tau2Command(Tau2Function::READ_SENSOR, tau2Word(0x0000)));
+		commands.push_back(Tau2Command(Tau2Function::READ_SENSOR, tau2Word(0x000A)));
+		commands.push_back(Tau2Command(Tau2Function::SHUTTER_TEMP));
+		commands.push_back(Tau2Command(Tau2Function::FFC_MODE_SELECT));
+		if (!serial->Execute(commands)) {
+			return false;
+		}
+		for (const Tau2Command &command : commands) {
+			if (command.response.size() < 2) {
+				return false;
+			}
+		}
+		uint16_t ffcMode = tau2ReadWord(commands[3].response);
+		snapshot.sensorTemperatureC = (int16_t) tau2ReadWord(commands[0].response) / 10.0;
+		snapshot.housingTemperatureC = (int16_t) tau2ReadWord(commands[1].response) / 100.0;
+		snapshot.shutterTemperatureC = (int16_t) tau2ReadWord(commands[2].response) / 100.0;
+		snapshot.ffcMode = ffcMode == 1 ? CameraSerialSettings::FFCModes::Auto
+				: ffcMode == 2 ? CameraSerialSettings::FFCModes::External : CameraSerialSettings::FFCModes::Manual;
+		return true;
+	}
+
+	Camera *cam;
+	CameraInfo info;
+	mutex serialMutex;			//* Serializes serial commands and guards the snapshot
+	std::unique_ptr<PvSerialLink> serialLink;	//* Guarded by serialMutex
+	std::unique_ptr<Tau2Serial> serial;
+	CameraTelemetrySnapshot snapshot;
+	std::chrono::steady_clock::duration maxAge;
+	atomic<double> serialRoundTripS{NAN};	//* Moving average over the snapshot reads, written under serialMutex
+};
+
+#endif /* CAMERA_TELEMETRY_H */
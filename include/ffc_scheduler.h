@@ -0,0 +1,192 @@
+/**
+ * @file   ffc_scheduler.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Flat field corrections timed by the capture instead of the camera.
+ *
+ * In automatic mode the camera runs an FFC whenever its own period or temperature delta
+ * says so, freezing the image in the middle of a measurement. FFCScheduler switches the
+ * source to manual FFC and triggers it itself: once the housing temperature has drifted by
+ * more than a threshold since the last FFC, or the maximum interval has passed, the FFC
+ * runs at the next gap between measurement windows. A gap opens every window length and
+ * stays open for the gap length, and at least until the first check after it opened, so a
+ * late check cannot miss it. While the FFC runs IsFFCActive() is set so the acquisition
+ * can drop or tag the frames.
+ */
+
+#ifndef FFC_SCHEDULER_H
+#define FFC_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "frame_source.h"
+#include "telemetry_poller.h"
+
+/**
+ * When FFCScheduler runs a flat field correction.
+ */
+struct FFCScheduleOptions {
+	double driftC = 0.5;		//* Housing temperature change since the last FFC that makes one due
+	double maxIntervalS = 0.0;	//* Time since the last FFC that makes one due, 0 = drift only
+	double windowS = 0.0;		//* Length of a measurement window, FFC only between windows, 0 = any time
+	double gapS = 1.0;		//* Time after the end of a window in which an FFC may start
+	double settleS = 0.1;		//* Frames stay flagged this long after the shutter opened
+	double checkIntervalS = 0.1;	//* How often the schedule is checked
+	bool dropFrames = true;		//* Drop frames captured during FFC instead of tagging them
+};
+
+class FFCScheduler {
+public:
+	/**
+	 * @param poller source of housing temperatures if running, else the source is asked
+	 */
+	FFCScheduler(FrameSource &source, const FFCScheduleOptions &options, TelemetryPoller *poller = NULL) :
+			source(source), options(options), poller(poller) {
+	}
+
+	~FFCScheduler() {
+		Stop();
+	}
+
+	FFCScheduler(const FFCScheduler &) = delete;
+	FFCScheduler &operator=(const FFCScheduler &) = delete;
+
+	/**
+	 * Switches the source to manual FFC and starts the scheduler thread.
+	 * @return false if the source does not support manual FFC
+	 */
+	bool Start() {
+		if (scheduler.joinable()) {
+			return true;
+		}
+		if (!source.SetManualFFC(true)) {
+			return false;
+		}
+		stopping = false;
+		scheduler = std::thread(&FFCScheduler::Run, this);
+		return true;
+	}
+
+	/**
+	 * Stops the thread and hands FFC back to the camera in the mode it had before Start().
+	 */
+	void Stop() {
+		if (!scheduler.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		scheduler.join();
+		source.SetManualFFC(false);
+	}
+
+	/**
+	 * @return true from triggering an FFC until it has finished and settled
+	 */
+	bool IsFFCActive() const {
+		return active.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * Tags the flags of a frame retrieved now with frameFlagFFC while an FFC is active.
+	 * @return true if the frame, tagged here or by the source, is to be dropped
+	 */
+	bool TagFrame(uint32_t &flags) const {
+		if (IsFFCActive()) {
+			flags |= frameFlagFFC;
+		}
+		return (flags & frameFlagFFC) && options.dropFrames;
+	}
+
+	/**
+	 * @return number of flat field corrections run
+	 */
+	uint64_t GetFFCCount() const {
+		return ffcCount;
+	}
+
+	/**
+	 * @return number of flat field corrections whose end the source could not observe
+	 */
+	uint64_t GetUnobservedFFCCount() const {
+		return unobservedCount;
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	void Run() {
+		Clock::time_point start = Clock::now();
+		Clock::time_point lastFFC = start;
+		Clock::time_point nextGap = start + Seconds(options.windowS);
+		double referenceC = HousingTemperature();
+		std::unique_lock<std::mutex> lock(wakeMutex);
+
+		while (!wake.wait_for(lock, Seconds(options.checkIntervalS), [this] { return stopping; })) {
+			lock.unlock();
+			Clock::time_point now = Clock::now();
+			double housingC = HousingTemperature();
+			bool due = std::fabs(housingC - referenceC) >= options.driftC
+					|| (options.maxIntervalS > 0.0 && now - lastFFC >= Seconds(options.maxIntervalS));
+			bool inGap = options.windowS <= 0.0 || now >= nextGap;
+			bool performed = due && inGap;
+
+			if (performed) {
+				Perform();
+				lastFFC = Clock::now();
+				referenceC = HousingTemperature();
+			}
+			if (options.windowS > 0.0 && inGap && (performed || now >= nextGap + Seconds(options.gapS))) {
+				// The gap is over or the FFC took its place, the next window starts now
+				while (nextGap <= Clock::now()) {
+					nextGap += Seconds(options.windowS);
+				}
+			}
+			lock.lock();
+		}
+	}
+
+	void Perform() {
+		active.store(true, std::memory_order_release);
+		if (!source.PerformFFC()) {
+			++unobservedCount;
+		}
+		std::this_thread::sleep_for(Seconds(options.settleS));
+		++ffcCount;
+		active.store(false, std::memory_order_release);
+	}
+
+	double HousingTemperature() {
+		if (poller != NULL) {
+			std::shared_ptr<const TemperatureSnapshot> snapshot = poller->GetSnapshot();
+			if (snapshot) {
+				return snapshot->housingTemperatureC;
+			}
+		}
+		return source.GetHousingTemperature();
+	}
+
+	static Clock::duration Seconds(double s) {
+		return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+	}
+
+	FrameSource &source;
+	FFCScheduleOptions options;
+	TelemetryPoller *poller;
+	std::atomic<bool> active{false};
+	std::atomic<uint64_t> ffcCount{0};
+	std::atomic<uint64_t> unobservedCount{0};
+	std::thread scheduler;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+};
+
+#endif /* FFC_SCHEDULER_H */
@@ -0,0 +1,251 @@
+/**
+ * @file   frame_aligner.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Groups the frames of hardware synchronized cameras into tuples.
+ *
+ * With one camera as sync master and the others as slaves every camera takes a frame on
+ * the same pulse, but the frames arrive at the host independently and any camera can lose
+ * one. FrameAligner looks at the oldest frame of every camera's ring and decides which of
+ * them were taken on the same pulse, either by host retrieval time within a tolerance or
+ * by block ID counted from each camera's first frame. Cameras without a frame for a pulse
+ * are reported as misses so the remaining frames can be flagged.
+ *
+ * A camera that lost its first frames, or started a pulse late, would have its block IDs
+ * counted from the wrong pulse. So frames matched by block ID must also agree in host time
+ * within the tolerance; where they do not, every camera is anchored again on the pulse its
+ * host time falls on, and the re-anchoring is counted.
+ */
+
+#ifndef FRAME_ALIGNER_H
+#define FRAME_ALIGNER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "frame_ring.h"
+
+/**
+ * What decides that frames of different cameras belong together.
+ */
+enum class AlignMode {
+	HostTimestamp,	//* FrameSlot::hostTimestamp within the tolerance
+	BlockId		//* Same FrameSlot::blockId offset from the camera's first frame
+};
+
+class FrameAligner {
+public:
+	/**
+	 * @param rings one ring per camera, filled by the acquisition threads
+	 * @param toleranceNs largest host timestamp difference within a tuple, half a frame
+	 * period
+	 * @param maxWaitNs how long after its retrieval a frame waits for the other cameras
+	 * before the tuple is given up as incomplete
+	 */
+	FrameAligner(const std::vector<FrameRing *> &rings, AlignMode mode, uint64_t toleranceNs, uint64_t maxWaitNs) :
+			rings(rings), mode(mode), toleranceNs(toleranceNs), maxWaitNs(maxWaitNs),
+			firstBlockId(rings.size(), 0), lastBlockId(rings.size(), 0), blockIdBase(rings.size(), 0),
+			started(rings.size(), false), misses(rings.size(), 0) {
+	}
+
+	/**
+	 * Forms the next tuple from the oldest frame of every ring, if it can be decided yet.
+	 * The frames stay in their rings until Commit().
+	 * @param members filled with one slot per camera, NULL for cameras that missed the tuple
+	 * @param nowNs current host time on the FrameSlot::hostTimestamp scale
+	 * @param final no more frames will arrive, decide with what the rings hold
+	 * @return false if there is no frame or a camera may still deliver one for the tuple
+	 */
+	bool Next(std::vector<FrameSlot *> &members, uint64_t nowNs, bool final) {
+		std::vector<FrameSlot *> oldest(rings.size(), NULL);
+		bool anyFrame = false;
+		bool anyEmpty = false;
+
+		for (size_t i = 0; i < rings.size(); ++i) {
+			oldest[i] = rings[i]->BeginRead();
+			if (oldest[i] == NULL) {
+				anyEmpty = true;
+				continue;
+			}
+			if (!started[i]) {
+				firstBlockId[i] = oldest[i]->blockId;
+				started[i] = true;
+			}
+			anyFrame = true;
+		}
+		if (!anyFrame) {
+			return false;
+		}
+
+		uint64_t referenceHost = Match(oldest, members);
+		if (mode == AlignMode::BlockId && !HostTimesAgree(members)) {
+			Reanchor(oldest);
+			referenceHost = Match(oldest, members);
+		}
+		size_t matched = 0;
+		for (size_t i = 0; i < rings.size(); ++i) {
+			matched += members[i] != NULL;
+		}
+		// A camera with an empty ring may still deliver the frame for the reference pulse
+		if (matched < rings.size() && anyEmpty && !final && nowNs < referenceHost + maxWaitNs) {
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Consumes the frames of the tuple returned by Next() and counts it.
+	 */
+	void Commit(const std::vector<FrameSlot *> &members) {
+		bool complete = true;
+		for (size_t i = 0; i < rings.size(); ++i) {
+			if (members[i] != NULL) {
+				blockIdBase[i] = BlockIdBase(i, *members[i]);
+				lastBlockId[i] = members[i]->blockId;
+				rings[i]->CommitRead();
+			} else {
+				++misses[i];
+				complete = false;
+			}
+		}
+		++(complete ? tuples : incompleteTuples);
+	}
+
+	/**
+	 * @return tuples with a frame from every camera
+	 */
+	uint64_t GetTuples() const {
+		return tuples;
+	}
+
+	/**
+	 * @return tuples at least one camera had no frame for
+	 */
+	uint64_t GetIncompleteTuples() const {
+		return incompleteTuples;
+	}
+
+	/**
+	 * @return tuples the given camera had no frame for
+	 */
+	uint64_t GetMisses(size_t camera) const {
+		return misses[camera];
+	}
+
+	/**
+	 * @return times the block ID anchors disagreed with the host times and were reset
+	 */
+	uint64_t GetReanchors() const {
+		return reanchors;
+	}
+
+private:
+	/**
+	 * Keeps the oldest frames taken on the earliest pulse and drops the later ones.
+	 * @return host timestamp of the frame that decided the earliest pulse
+	 */
+	uint64_t Match(const std::vector<FrameSlot *> &oldest, std::vector<FrameSlot *> &members) const {
+		bool anyFrame = false;
+		uint64_t reference = 0;
+		uint64_t referenceHost = 0;
+
+		for (size_t i = 0; i < rings.size(); ++i) {
+			if (oldest[i] == NULL) {
+				continue;
+			}
+			uint64_t key = Key(i, *oldest[i]);
+			if (!anyFrame || key < reference) {
+				reference = key;
+				referenceHost = oldest[i]->hostTimestamp;
+			}
+			anyFrame = true;
+		}
+		members = oldest;
+		for (size_t i = 0; i < rings.size(); ++i) {
+			if (members[i] != NULL && Key(i, *members[i]) - reference > Tolerance()) {
+				// Taken on a later pulse, this camera missed the reference one
+				members[i] = NULL;
+			}
+		}
+		return referenceHost;
+	}
+
+	bool HostTimesAgree(const std::vector<FrameSlot *> &members) const {
+		uint64_t earliest = UINT64_MAX;
+		uint64_t latest = 0;
+		for (FrameSlot *member : members) {
+			if (member != NULL) {
+				earliest = std::min(earliest, member->hostTimestamp);
+				latest = std::max(latest, member->hostTimestamp);
+			}
+		}
+		return latest <= earliest || latest - earliest <= toleranceNs;
+	}
+
+	/**
+	 * Moves the block ID anchors so that every camera's oldest frame gets the key of the
+	 * pulse its host time falls on, counted in frame periods from the earliest frame.
+	 */
+	void Reanchor(const std::vector<FrameSlot *> &oldest) {
+		size_t first = rings.size();
+		for (size_t i = 0; i < rings.size(); ++i) {
+			if (oldest[i] != NULL && (first == rings.size() || oldest[i]->hostTimestamp < oldest[first]->hostTimestamp)) {
+				first = i;
+			}
+		}
+		uint64_t firstKey = Key(first, *oldest[first]);
+		double periodNs = 2.0 * toleranceNs;
+		for (size_t i = 0; i < rings.size(); ++i) {
+			if (oldest[i] != NULL) {
+				uint64_t pulses = std::llround((oldest[i]->hostTimestamp - oldest[first]->hostTimestamp) / periodNs);
+				// Unsigned wrap around is intended, the anchor may lie before block ID 0
+				firstBlockId[i] += Key(i, *oldest[i]) - (firstKey + pulses);
+			}
+		}
+		++reanchors;
+	}
+
+	uint64_t Key(size_t camera, const FrameSlot &slot) const {
+		if (mode == AlignMode::BlockId) {
+			return BlockIdBase(camera, slot) + slot.blockId - firstBlockId[camera];
+		}
+		return slot.hostTimestamp;
+	}
+
+	/**
+	 * Keeps the block IDs of a camera counting on across 16 bit wraps, see isBlockIdWrap().
+	 * After a restart of the camera's stream its next frame continues right after the last
+	 * one, so the camera is not out of step with the others from then on.
+	 * @return amount to add to the block ID of the slot to make it count on
+	 */
+	uint64_t BlockIdBase(size_t camera, const FrameSlot &slot) const {
+		uint64_t last = lastBlockId[camera];
+		if (slot.blockId >= last) {
+			return blockIdBase[camera];
+		}
+		if (isBlockIdWrap(last, slot.blockId)) {
+			return blockIdBase[camera] + 0xFFFF;
+		}
+		return blockIdBase[camera] + last + 1 - slot.blockId;
+	}
+
+	uint64_t Tolerance() const {
+		return mode == AlignMode::BlockId ? 0 : toleranceNs;
+	}
+
+	std::vector<FrameRing *> rings;
+	AlignMode mode;
+	uint64_t toleranceNs;
+	uint64_t maxWaitNs;
+	std::vector<uint64_t> firstBlockId;	//* Block ID of each camera's first frame
+	std::vector<uint64_t> lastBlockId;	//* Block ID of each camera's last committed frame
+	std::vector<uint64_t> blockIdBase;	//* Block IDs lost to wrap arounds per camera
+	std::vector<bool> started;		//* The camera's first frame has been seen
+	std::vector<uint64_t> misses;
+	uint64_t tuples = 0;
+	uint64_t incompleteTuples = 0;
+	uint64_t reanchors = 0;
+};
+
+#endif /* FRAME_ALIGNER_H */
@@ -0,0 +1,295 @@
+/**
+ * @file   frame_kernels.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Vectorised per frame operations on raw 14-bit pixel buffers.
+ *
+ * Every kernel has a scalar reference (the ...Scalar functions) and a dispatching version
+ * that uses NEON on ARM (Raspberry Pi) or SSE2 on x86, selected at compile time. The
+ * integer kernels are bit-exact with the scalar path. The float kernels use separate
+ * multiply and add (no fused multiply-add), so they match the scalar path as long as the
+ * compiler does not contract the scalar expression, which is the case for -std=c++0x.
+ * On ARMv7 NEON has to be enabled with -mfpu=neon, see the makefile.
+ */
+
+#ifndef FRAME_KERNELS_H
+#define FRAME_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FRAME_KERNELS_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FRAME_KERNELS_SSE2 1
+#endif
+
+static const uint16_t raw14Mask = 0x3FFF;
+
+/**
+ * Minimum, maximum and mean of a frame.
+ */
+struct FrameStatistics {
+	uint16_t min = 0;
+	uint16_t max = 0;
+	double mean = 0.0;
+};
+
+/**
+ * @return name of the instruction set the kernels were compiled for
+ */
+inline const char *frameKernelsIsa() {
+#if defined(FRAME_KERNELS_NEON)
+	return "NEON";
+#elif defined(FRAME_KERNELS_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+//**********************************************************************************************************************
+// SCALAR REFERENCE
+//**********************************************************************************************************************
+
+/**
+ * Clears the bits above the 14-bit raw range. in and out may be the same buffer.
+ */
+inline void maskRaw14Scalar(const uint16_t *in, uint16_t *out, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = in[i] & raw14Mask;
+	}
+}
+
+/**
+ * out = raw * gain + offset
+ */
+inline void scaleRawScalar(const uint16_t *in, float *out, size_t count, float gain, float offset) {
+	for (size_t i = 0; i < count; ++i) {
+		float product = (float) in[i] * gain;
+		out[i] = product + offset;
+	}
+}
+
+inline FrameStatistics frameStatisticsScalar(const uint16_t *in, size_t count) {
+	FrameStatistics stats;
+	uint64_t sum = 0;
+
+	if (count == 0) {
+		return stats;
+	}
+	stats.min = stats.max = in[0];
+	for (size_t i = 0; i < count; ++i) {
+		if (in[i] < stats.min) {
+			stats.min = in[i];
+		}
+		if (in[i] > stats.max) {
+			stats.max = in[i];
+		}
+		sum += in[i];
+	}
+	stats.mean = (double) sum / count;
+	return stats;
+}
+
+/**
+ * @return factor mapping the range low..high onto 0..255
+ */
+inline float agcScale(uint16_t low, uint16_t high) {
+	return 255.0f / (high > low ? high - low : 1);
+}
+
+/**
+ * Linear AGC: low maps to 0, high and above to 255, values are truncated.
+ */
+inline void agcToByteScalar(const uint16_t *in, uint8_t *out, size_t count, uint16_t low, uint16_t high) {
+	float scale = agcScale(low, high);
+	for (size_t i = 0; i < count; ++i) {
+		uint16_t d = in[i] > low ? in[i] - low : 0;
+		float value = (float) d * scale;
+		out[i] = value >= 255.0f ? 255 : (uint8_t) value;
+	}
+}
+
+//**********************************************************************************************************************
+// DISPATCHING KERNELS
+//**********************************************************************************************************************
+
+/**
+ * Clears the bits above the 14-bit raw range. in and out may be the same buffer.
+ */
+inline void maskRaw14(const uint16_t *in, uint16_t *out, size_t count) {
+	size_t i = 0;
+#if defined(FRAME_KERNELS_NEON)
+	uint16x8_t mask = vdupq_n_u16(raw14Mask);
+	for (; i + 8 <= count; i += 8) {
+		vst1q_u16(out + i, vandq_u16(vld1q_u16(in + i), mask));
+	}
+#elif defined(FRAME_KERNELS_SSE2)
+	__m128i mask = _mm_set1_epi16(raw14Mask);
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+		_mm_storeu_si128((__m128i *) (out + i), _mm_and_si128(v, mask));
+	}
+#endif
+	maskRaw14Scalar(in + i, out + i, count - i);
+}
+
+/**
+ * out = raw * gain + offset
+ */
+inline void scaleRaw(const uint16_t *in, float *out, size_t count, float gain, float offset) {
+	size_t i = 0;
+#if defined(FRAME_KERNELS_NEON)
+	float32x4_t g = vdupq_n_f32(gain);
+	float32x4_t o = vdupq_n_f32(offset);
+	for (; i + 8 <= count; i += 8) {
+		uint16x8_t v = vld1q_u16(in + i);
+		float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+		float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v)));
+		vst1q_f32(out + i, vaddq_f32(vmulq_f32(lo, g), o));
+		vst1q_f32(out + i + 4, vaddq_f32(vmulq_f32(hi, g), o));
+	}
+#elif defined(FRAME_KERNELS_SSE2)
+	__m128 g = _mm_set1_ps(gain);
+	__m128 o = _mm_set1_ps(offset);
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+		__m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+		__m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(lo, g), o));
+		_mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_mul_ps(hi, g), o));
+	}
+#endif
+	scaleRawScalar(in + i, out + i, count - i, gain, offset);
+}
+
+/**
+ * Raw values to floats, out = raw * scale
+ */
+inline void rawToFloat(const uint16_t *in, float *out, size_t count, float scale = 1.0f) {
+	scaleRaw(in, out, count, scale, 0.0f);
+}
+
+/**
+ * Linear approximation of the raw to temperature curve, out = raw * gain + offset [°C].
+ * Good over a narrow scene range; use TemperatureLut for the exact curve.
+ */
+inline void linearTemperatureC(const uint16_t *in, float *out, size_t count, float gain, float offset) {
+	scaleRaw(in, out, count, gain, offset);
+}
+
+inline FrameStatistics frameStatistics(const uint16_t *in, size_t count) {
+	// 32-bit lane sums are folded into the total before they can overflow
+	const size_t block = 8 * 8192;
+	FrameStatistics stats;
+	uint64_t sum = 0;
+	size_t i = 0;
+
+	if (count == 0) {
+		return stats;
+	}
+	stats.min = stats.max = in[0];
+#if defined(FRAME_KERNELS_NEON)
+	if (count >= 8) {
+		uint16x8_t vmin = vld1q_u16(in);
+		uint16x8_t vmax = vmin;
+		while (i + 8 <= count) {
+			uint32x4_t acc = vdupq_n_u32(0);
+			size_t end = i + block < count ? i + block : count;
+			for (; i + 8 <= end; i += 8) {
+				uint16x8_t v = vld1q_u16(in + i);
+				vmin = vminq_u16(vmin, v);
+				vmax = vmaxq_u16(vmax, v);
+				acc = vpadalq_u16(acc, v);
+			}
+			uint64x2_t acc64 = vpaddlq_u32(acc);
+			sum += vgetq_lane_u64(acc64, 0) + vgetq_lane_u64(acc64, 1);
+		}
+		uint16_t lanes[16];
+		vst1q_u16(lanes, vmin);
+		vst1q_u16(lanes + 8, vmax);
+		for (int l = 0; l < 8; ++l) {
+			stats.min = lanes[l] < stats.min ? lanes[l] : stats.min;
+			stats.max = lanes[8 + l] > stats.max ? lanes[8 + l] : stats.max;
+		}
+	}
+#elif defined(FRAME_KERNELS_SSE2)
+	if (count >= 8) {
+		// SSE2 only has signed 16-bit min/max, so values are biased into the signed range
+		__m128i bias = _mm_set1_epi16((short) 0x8000);
+		__m128i zero = _mm_setzero_si128();
+		__m128i vmin = _mm_xor_si128(_mm_loadu_si128((const __m128i *) in), bias);
+		__m128i vmax = vmin;
+		while (i + 8 <= count) {
+			__m128i acc = _mm_setzero_si128();
+			size_t end = i + block < count ? i + block : count;
+			for (; i + 8 <= end; i += 8) {
+				__m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+				__m128i s = _mm_xor_si128(v, bias);
+				vmin = _mm_min_epi16(vmin, s);
+				vmax = _mm_max_epi16(vmax, s);
+				acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+				acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+			}
+			uint32_t lanes[4];
+			_mm_storeu_si128((__m128i *) lanes, acc);
+			sum += (uint64_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		}
+		uint16_t lanes[16];
+		_mm_storeu_si128((__m128i *) lanes, _mm_xor_si128(vmin, bias));
+		_mm_storeu_si128((__m128i *) (lanes + 8), _mm_xor_si128(vmax, bias));
+		for (int l = 0; l < 8; ++l) {
+			stats.min = lanes[l] < stats.min ? lanes[l] : stats.min;
+			stats.max = lanes[8 + l] > stats.max ? lanes[8 + l] : stats.max;
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		stats.min = in[i] < stats.min ? in[i] : stats.min;
+		stats.max = in[i] > stats.max ? in[i] : stats.max;
+		sum += in[i];
+	}
+	stats.mean = (double) sum / count;
+	return stats;
+}
+
+/**
+ * Linear AGC: low maps to 0, high and above to 255, values are truncated.
+ */
+inline void agcToByte(const uint16_t *in, uint8_t *out, size_t count, uint16_t low, uint16_t high) {
+	float scale = agcScale(low, high);
+	size_t i = 0;
+#if defined(FRAME_KERNELS_NEON)
+	uint16x8_t vlow = vdupq_n_u16(low);
+	float32x4_t vscale = vdupq_n_f32(scale);
+	for (; i + 8 <= count; i += 8) {
+		uint16x8_t d = vqsubq_u16(vld1q_u16(in + i), vlow);
+		uint32x4_t lo = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(d))), vscale));
+		uint32x4_t hi = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(d))), vscale));
+		uint16x8_t narrow = vcombine_u16(vqmovn_u32(lo), vqmovn_u32(hi));
+		vst1_u8(out + i, vqmovn_u16(narrow));
+	}
+#elif defined(FRAME_KERNELS_SSE2)
+	__m128i vlow = _mm_set1_epi16((short) low);
+	__m128 vscale = _mm_set1_ps(scale);
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i packed[2];
+		for (int h = 0; h < 2; ++h) {
+			__m128i d = _mm_subs_epu16(_mm_loadu_si128((const __m128i *) (in + i + 8 * h)), vlow);
+			// Products stay below 2^24, so the int32 conversion cannot overflow
+			__m128i lo = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(d, zero)), vscale));
+			__m128i hi = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(d, zero)), vscale));
+			packed[h] = _mm_packs_epi32(lo, hi);
+		}
+		_mm_storeu_si128((__m128i *) (out + i), _mm_packus_epi16(packed[0], packed[1]));
+	}
+#endif
+	agcToByteScalar(in + i, out + i, count - i, low, high);
+}
+
+#endif /* FRAME_KERNELS_H */
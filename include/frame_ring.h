@@ -0,0 +1,141 @@
+/**
+ * @file   frame_ring.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Lock-free single-producer/single-consumer ring of preallocated frame slots.
+ *
+ * The acquisition thread fills slots with BeginWrite()/CommitWrite() and the consumer
+ * drains them with BeginRead()/CommitRead(). Neither side ever blocks: a full ring makes
+ * BeginWrite() return NULL and the frame is counted as an overrun.
+ */
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Why frames are missing before a frame, bits of FrameSlot::gapReasons.
+ */
+static const uint32_t gapReasonMissingBlocks = 1 << 0;	//* Block IDs skipped, the frames never reached the host
+static const uint32_t gapReasonTimeout = 1 << 1;	//* Buffer retrieval timed out
+static const uint32_t gapReasonOverrun = 1 << 2;	//* Dropped because the ring was full
+static const uint32_t gapReasonFFC = 1 << 3;		//* Dropped because captured during FFC
+
+static const uint64_t blockIdWrapWindow = 0x1000;	//* Block IDs this close to either end of 16 bits count as a wrap
+
+/**
+ * GigE Vision 1.x block IDs are 16 bit and wrap from 65535 to 1. A block ID going back is
+ * a wrap only from the top of that range to its start, any other step back means the
+ * stream restarted, e.g. a looped recording or a reconnected camera.
+ */
+inline bool isBlockIdWrap(uint64_t previous, uint64_t current) {
+	return current < previous && previous <= 0xFFFF && previous > 0xFFFF - blockIdWrapWindow
+			&& current <= blockIdWrapWindow;
+}
+
+/**
+ * One frame held by the ring.
+ */
+struct FrameSlot {
+	uint64_t id = 0;			//* Sequence number assigned by the producer
+	uint64_t timestamp = 0;			//* Acquisition timestamp
+	uint64_t hostTimestamp = 0;		//* Host steady clock at retrieval [ns] since the capture's time base
+	uint64_t blockId = 0;			//* Stream block ID, 0 if the source has none
+	float sensorTemperatureC = 0.0f;	//* Sensor temperature when the frame was taken [°C]
+	float housingTemperatureC = 0.0f;	//* Housing temperature when the frame was taken [°C]
+	float shutterTemperatureC = 0.0f;	//* Shutter temperature when the frame was taken [°C]
+	uint32_t flags = 0;			//* frameFlag... bits
+	uint32_t gapFrames = 0;			//* Frames known to be missing right before this one
+	uint32_t gapReasons = 0;		//* gapReason... bits, non-zero if anything went missing before this frame
+	std::vector<uint16_t> pixels;		//* Row-major raw pixel values
+};
+
+class FrameRing {
+public:
+	/**
+	 * Allocates all slots up front so no allocation happens while streaming.
+	 * @param capacity number of slots
+	 * @param pixelsPerFrame width x height of a frame
+	 */
+	FrameRing(size_t capacity, size_t pixelsPerFrame) : slots(capacity) {
+		for (size_t i = 0; i < slots.size(); ++i) {
+			slots[i].pixels.resize(pixelsPerFrame);
+		}
+	}
+
+	/**
+	 * Producer side: slot to fill next.
+	 * @return free slot, or NULL if the consumer has fallen behind (counted as overrun)
+	 */
+	FrameSlot *BeginWrite() {
+		uint64_t w = writeIndex.load(std::memory_order_relaxed);
+		if (w - readIndex.load(std::memory_order_acquire) == slots.size()) {
+			overruns.fetch_add(1, std::memory_order_relaxed);
+			return NULL;
+		}
+		return &slots[w % slots.size()];
+	}
+
+	/**
+	 * Producer side: publishes the slot returned by BeginWrite().
+	 */
+	void CommitWrite() {
+		writeIndex.store(writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Consumer side: oldest filled slot.
+	 * @return filled slot, or NULL if the ring is empty
+	 */
+	FrameSlot *BeginRead() {
+		uint64_t r = readIndex.load(std::memory_order_relaxed);
+		if (r == writeIndex.load(std::memory_order_acquire)) {
+			return NULL;
+		}
+		return &slots[r % slots.size()];
+	}
+
+	/**
+	 * Consumer side: hands the slot returned by BeginRead() back to the producer.
+	 */
+	void CommitRead() {
+		readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @return number of filled slots waiting for the consumer, from any thread. The read
+	 * index is loaded first: it only grows towards the write index loaded after it.
+	 */
+	size_t GetSize() const {
+		uint64_t r = readIndex.load(std::memory_order_acquire);
+		uint64_t w = writeIndex.load(std::memory_order_acquire);
+		uint64_t size = w > r ? w - r : 0;
+		return size < slots.size() ? size : slots.size();
+	}
+
+	size_t GetCapacity() const {
+		return slots.size();
+	}
+
+	/**
+	 * @return number of frames rejected because the ring was full
+	 */
+	uint64_t GetOverruns() const {
+		return overruns.load(std::memory_order_relaxed);
+	}
+
+private:
+	FrameRing(const FrameRing &);
+	FrameRing &operator=(const FrameRing &);
+
+	std::vector<FrameSlot> slots;
+	alignas(64) std::atomic<uint64_t> writeIndex{0};	//* Only written by the producer
+	alignas(64) std::atomic<uint64_t> readIndex{0};		//* Only written by the consumer
+	alignas(64) std::atomic<uint64_t> overruns{0};
+};
+
+#endif /* FRAME_RING_H */
@@ -0,0 +1,177 @@
+/**
+ * @file   frame_source.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Interface of everything frames can be captured from.
+ *
+ * Mirrors the part of Camera and CameraSerialSettings the capture path uses, so the live
+ * camera (CameraFrameSource) and hardware free sources such as SimulatedCamera are
+ * interchangeable. Use is the same as for Camera: StartAcquisition(), then RetreiveBuffer()
+ * and ReleaseBuffer() per frame, and lastly StopAcquisition().
+ */
+
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "pipeline_sizer.h"
+#include "temperature_lut.h"
+
+/**
+ * Bits of the per frame flags.
+ */
+static const uint32_t frameFlagFFC = 1 << 0;		//* Captured while a flat field correction was running
+static const uint32_t frameFlagUnmatched = 1 << 1;	//* Synchronized capture: another camera has no frame for this one
+static const uint32_t frameFlagPartialLineMissing = 1 << 2;	//* Some lines of the image arrived incomplete
+static const uint32_t frameFlagFullLineMissing = 1 << 3;	//* Whole lines of the image are missing
+static const uint32_t frameFlagTransferError = 1 << 4;	//* The transfer of the frame reported an error
+static const uint32_t frameFlagsIncomplete = frameFlagPartialLineMissing | frameFlagFullLineMissing
+		| frameFlagTransferError;
+
+/**
+ * Counters of the transport between the device and the host, e.g. the statistics of a
+ * Pleora PvStream, as name and value pairs in the order the transport lists them.
+ */
+struct TransportStatistics {
+	std::string transport;		//* "GEV", "U3V", ...
+	std::vector<std::pair<std::string, double> > values;
+};
+
+class FrameSource {
+public:
+	virtual ~FrameSource() {}
+
+	virtual int GetResolutionX() = 0;
+	virtual int GetResolutionY() = 0;
+	/**
+	 * @return nominal frame rate in Hz
+	 */
+	virtual double GetCameraSpeedHz() = 0;
+	virtual double GetSensorTemperature() = 0;
+	virtual double GetHousingTemperature() = 0;
+	/**
+	 * @return shutter temperature, NAN if the source has none
+	 */
+	virtual double GetShutterTemperature() {
+		return NAN;
+	}
+	/**
+	 * Gets all three temperatures from one reading of the device, taken now if refresh is
+	 * set, else only if cached values are older than their bound.
+	 */
+	virtual void GetTemperatures(double &sensorC, double &housingC, double &shutterC, bool refresh) {
+		(void) refresh;
+		sensorC = GetSensorTemperature();
+		housingC = GetHousingTemperature();
+		shutterC = GetShutterTemperature();
+	}
+	/**
+	 * @return recent time of one command to the device [s], NAN if the source has no link
+	 */
+	virtual double GetSerialRoundTripS() {
+		return NAN;
+	}
+
+	/**
+	 * @return provider of temperature tables for the current radiometric parameters
+	 */
+	virtual TemperatureLutSource &GetRadiometry() = 0;
+
+	/**
+	 * Applies buffer settings to the queue frames wait in until retrieved, before
+	 * StartAcquisition(). Settings the source has no equivalent for are ignored.
+	 * @return false if the source has no such queue or rejected the settings
+	 */
+	virtual bool ConfigurePipeline(const PipelineOptions &) {
+		return false;
+	}
+	/**
+	 * @return number of frames the queue holds, 0 if unbounded or unknown
+	 */
+	virtual uint32_t GetPipelineBufferCount() {
+		return 0;
+	}
+	/**
+	 * Resizes the queue, may be called by the thread retrieving while acquiring.
+	 */
+	virtual bool SetPipelineBufferCount(uint32_t) {
+		return false;
+	}
+	/**
+	 * Reads the transport statistics, may be called from another thread while acquiring
+	 * and must not stall the stream.
+	 * @return false if the source has no transport to report on
+	 */
+	virtual bool ReadTransportStatistics(TransportStatistics &) {
+		return false;
+	}
+
+	/**
+	 * @return true if frames arrive at the source's own pace and are lost when not retrieved
+	 * in time, false if the source waits for the caller, like a file or an unpaced simulation
+	 */
+	virtual bool IsLive() {
+		return true;
+	}
+
+	virtual void StartAcquisition() = 0;
+	virtual bool IsAcquiring() = 0;
+	/**
+	 * Waits for the next frame.
+	 * @return row-major raw pixels valid until ReleaseBuffer(), or NULL if no frame arrived
+	 */
+	virtual const uint16_t *RetreiveBuffer() = 0;
+	/**
+	 * @return timestamp of the frame returned by the last RetreiveBuffer()
+	 */
+	virtual uint64_t GetBufferTimestamp() = 0;
+	/**
+	 * @return stream block ID of the frame returned by the last RetreiveBuffer(), 0 if the
+	 * source does not number its frames
+	 */
+	virtual uint64_t GetBufferBlockId() {
+		return 0;
+	}
+	/**
+	 * Temperatures belonging to the frame returned by the last RetreiveBuffer(),
+	 * for sources that carry them per frame.
+	 * @return false if the source has no per frame temperatures
+	 */
+	virtual bool GetBufferTemperatures(float &, float &, float &) {
+		return false;
+	}
+	/**
+	 * @return frameFlag... bits the source knows for the frame returned by the last RetreiveBuffer()
+	 */
+	virtual uint32_t GetBufferFlags() {
+		return 0;
+	}
+	/**
+	 * Returns the current buffer to the source
+	 */
+	virtual void ReleaseBuffer() = 0;
+	virtual void StopAcquisition() = 0;
+
+	/**
+	 * Switches between flat field corrections on the camera's own schedule and only on
+	 * PerformFFC(). Switching back restores the mode the source had before.
+	 * @return false if the source cannot be switched
+	 */
+	virtual bool SetManualFFC(bool) {
+		return false;
+	}
+	/**
+	 * Runs a flat field correction, may be called from another thread while acquiring.
+	 * Returns once the image is valid again.
+	 * @return false if the end of the FFC could not be observed and a fixed time was waited
+	 */
+	virtual bool PerformFFC() {
+		return true;
+	}
+};
+
+#endif /* FRAME_SOURCE_H */
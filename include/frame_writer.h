@@ -0,0 +1,447 @@
+/**
+ * @file   frame_writer.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Output formats for captured frames.
+ *
+ * RawFrameWriter emits each frame as a fixed-size RawFrameHeader followed by the
+ * width x height 14-bit pixel values as little-endian uint16, in a single writev per frame.
+ * TextFrameWriter renders a whole frame as text into a reusable buffer and writes it at once.
+ * CelsiusFrameWriter does the same for the frame converted to °C through a TemperatureLut.
+ * Frames missing before a frame are recorded with it: in the header of the raw format and
+ * as a "Gap:" line before the frame in the text formats.
+ */
+
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+#include "frame_ring.h"
+#include "temperature_lut.h"
+
+/**
+ * Header preceding every frame in the binary output. All fields are little-endian.
+ */
+struct RawFrameHeader {
+	char magic[4];			//* "T2RF"
+	uint16_t version;		//* Format version, currently 4
+	uint16_t headerSize;		//* sizeof(RawFrameHeader), pixel data follows
+	uint64_t frameId;		//* Sequence number of the frame
+	uint64_t timestamp;		//* PvBuffer::GetTimestamp()
+	uint16_t width;			//* Pixels per row
+	uint16_t height;		//* Number of rows
+	float sensorTemperatureC;	//* Sensor temperature [°C]
+	float housingTemperatureC;	//* Housing temperature [°C]
+	float shutterTemperatureC;	//* Shutter temperature [°C], NAN if unknown, 0 in early recordings
+	// Version 2
+	uint32_t flags;			//* FrameSlot::flags
+	uint32_t gapFrames;		//* FrameSlot::gapFrames, always 0 before version 4
+	// Version 3
+	uint64_t hostTimestamp;		//* FrameSlot::hostTimestamp
+	// Version 4
+	uint64_t blockId;		//* FrameSlot::blockId
+	uint32_t gapReasons;		//* FrameSlot::gapReasons
+	uint32_t reserved;
+};
+static_assert(sizeof(RawFrameHeader) == 72, "RawFrameHeader must not contain padding");
+
+/**
+ * Header size of every format version, earlier versions end before the later fields.
+ */
+static const size_t rawFrameHeaderSizes[] = { 0, 40, 48, 56, 72 };
+static const uint16_t rawFrameVersion = 4;
+
+/**
+ * Fills the fixed fields of a header for frames of the given size.
+ */
+inline void initRawFrameHeader(RawFrameHeader &header, int width, int height) {
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "T2RF", 4);
+	header.version = rawFrameVersion;
+	header.headerSize = sizeof(RawFrameHeader);
+	header.width = width;
+	header.height = height;
+}
+
+/**
+ * Fills the per frame fields of a header initialized by initRawFrameHeader().
+ */
+inline void encodeRawFrameHeader(RawFrameHeader &header, const FrameSlot &frame) {
+	header.frameId = frame.id;
+	header.timestamp = frame.timestamp;
+	header.sensorTemperatureC = frame.sensorTemperatureC;
+	header.housingTemperatureC = frame.housingTemperatureC;
+	header.shutterTemperatureC = frame.shutterTemperatureC;
+	header.flags = frame.flags;
+	header.hostTimestamp = frame.hostTimestamp;
+	header.blockId = frame.blockId;
+	header.gapFrames = frame.gapFrames;
+	header.gapReasons = frame.gapReasons;
+}
+
+/**
+ * Base of all output formats. Writing a frame runs three stages that can be timed
+ * separately: Convert() (optional per pixel conversion), Encode() (rendering the output
+ * into buffers owned by the writer) and Flush() (one gathered write of those buffers).
+ */
+class FrameWriter {
+public:
+	/**
+	 * @param fd descriptor the frames are written to, e.g. STDOUT_FILENO
+	 */
+	FrameWriter(int fd) : fd(fd) {
+	}
+
+	virtual ~FrameWriter() {}
+
+	/**
+	 * Writes one frame.
+	 * @return false if the output failed
+	 */
+	bool Write(const FrameSlot &frame) {
+		Convert(frame);
+		Encode(frame);
+		return Flush();
+	}
+
+	/**
+	 * Converts the pixels of the frame into the representation Encode() renders.
+	 */
+	virtual void Convert(const FrameSlot &) {
+	}
+
+	/**
+	 * Renders the frame into the output buffers.
+	 */
+	virtual void Encode(const FrameSlot &frame) = 0;
+
+	/**
+	 * Writes the buffers prepared by Encode() with as few system calls as the descriptor allows.
+	 * Once the output failed every following Flush() fails, see GetError().
+	 * @return false if the output failed
+	 */
+	bool Flush() {
+		struct iovec *iov = pending;
+		int count = pendingCount;
+
+		pendingCount = 0;
+		if (error != 0) {
+			errno = error;
+			return false;
+		}
+		while (count > 0) {
+			ssize_t n = writev(fd, iov, count);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				SetError(errno);
+				return false;
+			}
+			bytesWritten.fetch_add(n, std::memory_order_relaxed);
+			while (count > 0 && (size_t) n >= iov->iov_len) {
+				n -= iov->iov_len;
+				++iov;
+				--count;
+			}
+			if (count > 0) {
+				iov->iov_base = (char *) iov->iov_base + n;
+				iov->iov_len -= n;
+			}
+		}
+		framesWritten.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * @return errno of the first failed output, 0 while nothing failed
+	 */
+	int GetError() const {
+		return error;
+	}
+
+	/**
+	 * @return number of bytes written so far, may be read by other threads
+	 */
+	uint64_t GetBytesWritten() const {
+		return bytesWritten.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @return number of frames flushed completely so far, may be read by other threads
+	 */
+	uint64_t GetFramesWritten() const {
+		return framesWritten.load(std::memory_order_relaxed);
+	}
+
+protected:
+	/**
+	 * Formats the gap before the frame, if any, and queues it for the next Flush().
+	 */
+	void QueueGap(const FrameSlot &frame) {
+		if (frame.gapReasons == 0) {
+			return;
+		}
+		static const char *const reasons[] = { "missing blocks", "timeout", "overrun", "FFC" };
+		size_t n = AppendGapText(0, "Gap: %u frames missing before block %llu (", frame.gapFrames,
+				(unsigned long long) frame.blockId);
+		const char *separator = "";
+		for (int i = 0; i < 4; ++i) {
+			if (frame.gapReasons & (1 << i)) {
+				n = AppendGapText(n, "%s%s", separator, reasons[i]);
+				separator = ", ";
+			}
+		}
+		n = AppendGapText(n, ")\n");
+		Queue(gapText, n);
+	}
+
+	/**
+	 * Formats into gapText from position n on, truncating at its end.
+	 * @return new length of the text
+	 */
+	size_t AppendGapText(size_t n, const char *format, ...) {
+		va_list arguments;
+		va_start(arguments, format);
+		int length = vsnprintf(gapText + n, sizeof(gapText) - n, format, arguments);
+		va_end(arguments);
+		if (length < 0) {
+			return n;
+		}
+		return std::min(n + length, sizeof(gapText) - 1);
+	}
+
+	/**
+	 * Queues a buffer for the next Flush(), at most three per frame.
+	 */
+	void Queue(const void *data, size_t size) {
+		pending[pendingCount].iov_base = (void *) data;
+		pending[pendingCount].iov_len = size;
+		++pendingCount;
+	}
+
+	/**
+	 * Records output written by the writer itself rather than through Flush().
+	 */
+	void AddBytesWritten(uint64_t n) {
+		bytesWritten.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Makes every following Flush() fail with the given errno.
+	 */
+	void SetError(int e) {
+		if (error == 0) {
+			error = e;
+		}
+	}
+
+	int fd;
+
+private:
+	struct iovec pending[3];
+	int pendingCount = 0;
+	char gapText[128];			//* Fits the longest gap line, all reasons and 64 bit numbers
+	int error = 0;				//* errno of the first failure, in Flush() or outside
+	std::atomic<uint64_t> bytesWritten{0};
+	std::atomic<uint64_t> framesWritten{0};
+};
+
+class RawFrameWriter : public FrameWriter {
+public:
+	RawFrameWriter(int fd, int width, int height) : FrameWriter(fd) {
+		initRawFrameHeader(header, width, height);
+	}
+
+	void Encode(const FrameSlot &frame) {
+		encodeRawFrameHeader(header, frame);
+		Queue(&header, sizeof(header));
+		Queue(frame.pixels.data(), frame.pixels.size() * sizeof(uint16_t));
+	}
+
+private:
+	RawFrameHeader header;
+};
+
+/**
+ * Writes the decimal digits of value at p without locale or stream overhead.
+ * @return pointer past the last digit
+ */
+inline char *formatUint(char *p, uint32_t value) {
+	static const char digitPairs[] =
+		"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+	char tmp[10];
+	char *t = tmp + sizeof(tmp);
+
+	while (value >= 100) {
+		const char *pair = digitPairs + (value % 100) * 2;
+		value /= 100;
+		*--t = pair[1];
+		*--t = pair[0];
+	}
+	if (value >= 10) {
+		const char *pair = digitPairs + value * 2;
+		*--t = pair[1];
+		*--t = pair[0];
+	} else {
+		*--t = '0' + value;
+	}
+	size_t len = tmp + sizeof(tmp) - t;
+	memcpy(p, t, len);
+	return p + len;
+}
+
+static const float maxCentisValue = 99999.99f;	//* Larger magnitudes are clamped by formatCentis()
+static const size_t maxCentisLength = 9;	//* Sign, 5 digits, point and 2 decimals
+
+/**
+ * Writes value with two decimals, e.g. "-12.05", clamped to +-maxCentisValue so it never
+ * takes more than maxCentisLength characters. Values that are not a number are written as "nan".
+ * @return pointer past the last character
+ */
+inline char *formatCentis(char *p, float value) {
+	if (std::isnan(value)) {
+		return (char *) memcpy(p, "nan", 3) + 3;
+	}
+	value = value > maxCentisValue ? maxCentisValue : (value < -maxCentisValue ? -maxCentisValue : value);
+	long centis = lrintf(value * 100.0f);
+	if (centis < 0) {
+		*p++ = '-';
+		centis = -centis;
+	}
+	p = formatUint(p, centis / 100);
+	*p++ = '.';
+	*p++ = '0' + (centis % 100) / 10;
+	*p++ = '0' + centis % 10;
+	return p;
+}
+
+inline char *appendText(char *p, const char *text, size_t len) {
+	memcpy(p, text, len);
+	return p + len;
+}
+
+/**
+ * Layouts produced by TextFrameWriter.
+ */
+enum class TextLayout {
+	Matrix,		//* One comma separated line per row, frames separated by an empty line
+	PixelList	//* One "Row: y Column: x Raw: v" line per pixel
+};
+
+class TextFrameWriter : public FrameWriter {
+public:
+	TextFrameWriter(int fd, int width, int height, TextLayout layout = TextLayout::Matrix) :
+			FrameWriter(fd), width(width), height(height), layout(layout) {
+		// Worst case per pixel: 5 digits and a separator, or a full pixel list line
+		size_t perPixel = layout == TextLayout::Matrix ? 6 : 36;
+		text.resize((size_t) width * height * perPixel + 1);
+	}
+
+	void Encode(const FrameSlot &frame) {
+		QueueGap(frame);
+		Queue(text.data(), Format(frame.pixels.data()));
+	}
+
+	/**
+	 * Renders one frame into the internal buffer.
+	 * @return number of characters produced
+	 */
+	size_t Format(const uint16_t *pixels) {
+		char *p = text.data();
+
+		if (layout == TextLayout::Matrix) {
+			for (int y = 0; y < height; ++y) {
+				const uint16_t *row = pixels + (size_t) y * width;
+				for (int x = 0; x < width; ++x) {
+					p = formatUint(p, row[x]);
+					*p++ = ',';
+				}
+				p[-1] = '\n';
+			}
+			*p++ = '\n';
+		} else {
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
+					p = appendText(p, "Row: ", 5);
+					p = formatUint(p, y);
+					p = appendText(p, " Column: ", 9);
+					p = formatUint(p, x);
+					p = appendText(p, " Raw: ", 6);
+					p = formatUint(p, pixels[(size_t) y * width + x]);
+					*p++ = '\n';
+				}
+			}
+		}
+		return p - text.data();
+	}
+
+	const char *GetText() const {
+		return text.data();
+	}
+
+private:
+	int width;
+	int height;
+	TextLayout layout;
+	std::vector<char> text;	//* Reused for every frame
+};
+
+/**
+ * Writes frames as a comma separated matrix of temperatures in °C with two decimals.
+ * The table is rebuilt from the source whenever its parameters have changed.
+ */
+class CelsiusFrameWriter : public FrameWriter {
+public:
+	CelsiusFrameWriter(int fd, int width, int height, TemperatureLutSource &source) :
+			FrameWriter(fd), width(width), height(height), source(source), celsius((size_t) width * height) {
+		// Worst case per pixel: the longest clamped value and a separator
+		text.resize((size_t) width * height * (maxCentisLength + 1) + 1);
+	}
+
+	/**
+	 * Rebuilds the table if needed and converts the frame to °C.
+	 */
+	void Convert(const FrameSlot &frame) {
+		source.Refresh(lut);
+		lut.Convert(frame.pixels.data(), celsius.data(), celsius.size());
+	}
+
+	void Encode(const FrameSlot &frame) {
+		QueueGap(frame);
+		char *p = text.data();
+		for (int y = 0; y < height; ++y) {
+			const float *row = celsius.data() + (size_t) y * width;
+			for (int x = 0; x < width; ++x) {
+				p = formatCentis(p, row[x]);
+				*p++ = ',';
+			}
+			p[-1] = '\n';
+		}
+		*p++ = '\n';
+
+		Queue(text.data(), p - text.data());
+	}
+
+private:
+	int width;
+	int height;
+	TemperatureLutSource &source;
+	TemperatureLut lut;
+	std::vector<float> celsius;	//* Reused for every frame
+	std::vector<char> text;		//* Reused for every frame
+};
+
+#endif /* FRAME_WRITER_H */
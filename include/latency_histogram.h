@@ -0,0 +1,144 @@
+/**
+ * @file   latency_histogram.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Lock-free log-bucketed histogram of durations.
+ *
+ * Buckets are laid out as in HdrHistogram: every power of two range is split into
+ * subBucketHalf linear sub-buckets, so each recorded value lands in a bucket no wider than
+ * 1/subBucketHalf of its value, from nanoseconds up to minutes in a fixed array. Recording
+ * is a single relaxed atomic increment and may happen from any thread; readers take
+ * snapshots, which are consistent per bucket but not across buckets.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Counts of a LatencyHistogram at one point in time.
+ */
+struct LatencySnapshot {
+	std::vector<uint64_t> counts;	//* Per bucket
+	uint64_t maxNs = 0;		//* Largest value recorded, exact for cumulative snapshots
+
+	uint64_t GetCount() const {
+		uint64_t total = 0;
+		for (uint64_t c : counts) {
+			total += c;
+		}
+		return total;
+	}
+
+	/**
+	 * @return upper edge of the bucket holding the given percentile, 0 if empty
+	 */
+	uint64_t GetPercentileNs(double percentile) const;
+
+	/**
+	 * @return the values recorded after the earlier snapshot, whose max is the upper edge
+	 * of the highest bucket used in between
+	 */
+	LatencySnapshot Since(const LatencySnapshot &earlier) const;
+};
+
+class LatencyHistogram {
+public:
+	static const int subBucketBits = 4;
+	static const uint64_t subBucketHalf = 1 << subBucketBits;	//* Linear steps per power of two
+	static const int maxBits = 40;					//* Values from 2^40 ns (18 minutes) on share the last bucket
+	static const size_t bucketCount = (maxBits - subBucketBits + 1) * subBucketHalf;
+
+	LatencyHistogram() : counts(bucketCount) {
+		for (std::atomic<uint64_t> &c : counts) {
+			c.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	LatencyHistogram(const LatencyHistogram &) = delete;
+	LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+	void Record(uint64_t ns) {
+		counts[Index(ns)].fetch_add(1, std::memory_order_relaxed);
+		uint64_t max = maxNs.load(std::memory_order_relaxed);
+		while (ns > max && !maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+		}
+	}
+
+	LatencySnapshot Snapshot() const {
+		LatencySnapshot snapshot;
+		snapshot.counts.resize(bucketCount);
+		for (size_t i = 0; i < bucketCount; ++i) {
+			snapshot.counts[i] = counts[i].load(std::memory_order_relaxed);
+		}
+		snapshot.maxNs = maxNs.load(std::memory_order_relaxed);
+		return snapshot;
+	}
+
+	static size_t Index(uint64_t ns) {
+		if (ns < 2 * subBucketHalf) {
+			return ns;
+		}
+		int msb = 63 - __builtin_clzll(ns);
+		if (msb >= maxBits) {
+			return bucketCount - 1;
+		}
+		int shift = msb - subBucketBits;
+		return (shift + 1) * subBucketHalf + ((ns >> shift) - subBucketHalf);
+	}
+
+	/**
+	 * @return largest value that falls into the bucket
+	 */
+	static uint64_t UpperEdge(size_t index) {
+		if (index < 2 * subBucketHalf) {
+			return index;
+		}
+		int shift = index / subBucketHalf - 1;
+		uint64_t sub = index % subBucketHalf + subBucketHalf;
+		return ((sub + 1) << shift) - 1;
+	}
+
+private:
+	std::vector<std::atomic<uint64_t> > counts;
+	std::atomic<uint64_t> maxNs{0};
+};
+
+uint64_t LatencySnapshot::GetPercentileNs(double percentile) const {
+	uint64_t total = GetCount();
+	if (total == 0) {
+		return 0;
+	}
+	uint64_t rank = (uint64_t) std::ceil(percentile / 100.0 * total);
+	rank = rank < 1 ? 1 : (rank > total ? total : rank);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < counts.size(); ++i) {
+		seen += counts[i];
+		if (seen >= rank) {
+			uint64_t edge = LatencyHistogram::UpperEdge(i);
+			return maxNs != 0 && edge > maxNs ? maxNs : edge;
+		}
+	}
+	return maxNs;
+}
+
+LatencySnapshot LatencySnapshot::Since(const LatencySnapshot &earlier) const {
+	LatencySnapshot interval;
+	interval.counts.resize(counts.size());
+	for (size_t i = 0; i < counts.size(); ++i) {
+		interval.counts[i] = counts[i] - (i < earlier.counts.size() ? earlier.counts[i] : 0);
+		if (interval.counts[i] > 0) {
+			interval.maxNs = LatencyHistogram::UpperEdge(i);
+		}
+	}
+	if (interval.maxNs > maxNs) {
+		interval.maxNs = maxNs;
+	}
+	return interval;
+}
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,282 @@
+/**
+ * @file   metrics_exporter.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Capture counters in the Prometheus text exposition format.
+ *
+ * Streams register collectors that add their current values to a MetricsText, which groups
+ * the samples of every metric under one HELP and TYPE header. MetricsExporter renders all
+ * collectors either into a file that is rewritten at a fixed interval, through a temporary
+ * file and rename() so a scraper never reads half a file, or on every connection to a
+ * Unix domain socket, which receives the text and is closed.
+ */
+
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Samples of one scrape, grouped by metric.
+ */
+class MetricsText {
+public:
+	/**
+	 * @param type "counter" or "gauge"
+	 * @param labels label set without braces, e.g. camera="0", may be empty
+	 */
+	void Add(const std::string &name, const char *type, const char *help, const std::string &labels, double value) {
+		std::map<std::string, size_t>::iterator it = index.find(name);
+		if (it == index.end()) {
+			it = index.insert(std::make_pair(name, families.size())).first;
+			Family family;
+			family.name = name;
+			family.type = type;
+			family.help = help;
+			families.push_back(family);
+		}
+		char number[32];
+		snprintf(number, sizeof(number), "%.15g", value);
+		Family &family = families[it->second];
+		family.samples += name;
+		if (!labels.empty()) {
+			family.samples += "{" + labels + "}";
+		}
+		family.samples += " ";
+		family.samples += number;
+		family.samples += "\n";
+	}
+
+	std::string Render() const {
+		std::string text;
+		for (const Family &family : families) {
+			text += "# HELP " + family.name + " " + family.help + "\n";
+			text += "# TYPE " + family.name + " " + family.type + "\n";
+			text += family.samples;
+		}
+		return text;
+	}
+
+private:
+	struct Family {
+		std::string name;
+		std::string type;
+		std::string help;
+		std::string samples;
+	};
+
+	std::vector<Family> families;		//* In the order first added
+	std::map<std::string, size_t> index;	//* Name to position in families
+};
+
+class MetricsExporter {
+public:
+	typedef std::function<void(MetricsText &)> Collector;
+
+	/**
+	 * @param target file to rewrite, or "unix:" followed by the socket path
+	 * @param intervalS time between two rewrites of the file
+	 */
+	MetricsExporter(const std::string &target, double intervalS) : intervalS(intervalS) {
+		if (target.compare(0, 5, "unix:") == 0) {
+			socketPath = target.substr(5);
+		} else {
+			filePath = target;
+		}
+	}
+
+	~MetricsExporter() {
+		Stop();
+	}
+
+	MetricsExporter(const MetricsExporter &) = delete;
+	MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+	/**
+	 * Creates the socket or the first file and starts the exporter thread.
+	 * @return false with errno set if that failed
+	 */
+	bool Start() {
+		if (exporter.joinable()) {
+			return true;
+		}
+		if (!socketPath.empty()) {
+			struct sockaddr_un address;
+			memset(&address, 0, sizeof(address));
+			address.sun_family = AF_UNIX;
+			if (socketPath.size() >= sizeof(address.sun_path)) {
+				errno = ENAMETOOLONG;
+				return false;
+			}
+			strcpy(address.sun_path, socketPath.c_str());
+			listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (listenFd < 0) {
+				return false;
+			}
+			unlink(socketPath.c_str());
+			if (bind(listenFd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(listenFd, 4) != 0) {
+				int error = errno;
+				close(listenFd);
+				listenFd = -1;
+				errno = error;
+				return false;
+			}
+		} else if (!WriteFile()) {
+			return false;
+		}
+		stopping = false;
+		exporter = std::thread(&MetricsExporter::Run, this);
+		return true;
+	}
+
+	/**
+	 * Stops the thread, the file is written a last time and the socket removed.
+	 */
+	void Stop() {
+		if (!exporter.joinable()) {
+			return;
+		}
+		stopping = true;
+		exporter.join();
+		if (listenFd >= 0) {
+			close(listenFd);
+			listenFd = -1;
+			unlink(socketPath.c_str());
+		} else {
+			WriteFile();
+		}
+	}
+
+	/**
+	 * Registers a collector, called from the exporter thread until removed.
+	 * @return id to remove it with
+	 */
+	int AddCollector(const Collector &collector) {
+		std::lock_guard<std::mutex> lock(collectorsMutex);
+		collectors.push_back(std::make_pair(++lastId, collector));
+		return lastId;
+	}
+
+	/**
+	 * Removes a collector, waiting for a scrape that is using it to finish. Its final values
+	 * are kept and exported until the exporter stops, so counters do not vanish.
+	 */
+	void RemoveCollector(int id) {
+		std::lock_guard<std::mutex> lock(collectorsMutex);
+		for (size_t i = 0; i < collectors.size(); ++i) {
+			if (collectors[i].first == id) {
+				collectors[i].second(retired);
+				collectors.erase(collectors.begin() + i);
+				break;
+			}
+		}
+	}
+
+	std::string Render() {
+		std::lock_guard<std::mutex> lock(collectorsMutex);
+		MetricsText text = retired;
+		for (size_t i = 0; i < collectors.size(); ++i) {
+			collectors[i].second(text);
+		}
+		return text.Render();
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	/**
+	 * Polls in short steps so Stop() does not wait for a whole interval.
+	 */
+	void Run() {
+		static const int pollStepMs = 100;
+		Clock::time_point nextWrite = Clock::now() + Seconds(intervalS);
+
+		while (!stopping) {
+			if (listenFd >= 0) {
+				struct pollfd p = { listenFd, POLLIN, 0 };
+				if (poll(&p, 1, pollStepMs) > 0) {
+					Serve();
+				}
+			} else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(pollStepMs));
+				if (Clock::now() >= nextWrite) {
+					WriteFile();
+					nextWrite += Seconds(intervalS);
+				}
+			}
+		}
+	}
+
+	void Serve() {
+		int client = accept(listenFd, NULL, NULL);
+		if (client < 0) {
+			return;
+		}
+		std::string text = Render();
+		WriteAll(client, text);
+		close(client);
+	}
+
+	bool WriteFile() {
+		std::string temporary = filePath + ".tmp";
+		int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			return false;
+		}
+		bool ok = WriteAll(fd, Render());
+		close(fd);
+		return ok && rename(temporary.c_str(), filePath.c_str()) == 0;
+	}
+
+	static bool WriteAll(int fd, const std::string &text) {
+		const char *p = text.data();
+		size_t left = text.size();
+		while (left > 0) {
+			ssize_t n = send(fd, p, left, MSG_NOSIGNAL);
+			if (n < 0 && errno == ENOTSOCK) {
+				n = write(fd, p, left);
+			}
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) {
+				return false;
+			}
+			p += n;
+			left -= n;
+		}
+		return true;
+	}
+
+	static Clock::duration Seconds(double s) {
+		return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+	}
+
+	std::string filePath;
+	std::string socketPath;
+	double intervalS;
+	int listenFd = -1;
+	std::thread exporter;
+	std::atomic<bool> stopping{false};
+	std::mutex collectorsMutex;		//* Guards the collectors and serializes scrapes
+	std::vector<std::pair<int, Collector> > collectors;
+	MetricsText retired;			//* Final values of the removed collectors
+	int lastId = 0;
+};
+
+#endif /* METRICS_EXPORTER_H */
@@ -0,0 +1,91 @@
+/**
+ * @file   pipeline_sizer.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Depth of the buffer pipeline between the camera and the acquisition thread.
+ *
+ * The camera fills pipeline buffers at its frame rate whether or not they are taken out,
+ * and a frame arriving while every buffer is full is lost. The pipeline therefore has to
+ * hold as many frames as arrive during the longest time the acquisition thread stays
+ * away, which on a loaded host is set by scheduling rather than by the copy. PipelineSizer
+ * watches these stalls and grows the buffer count to cover them, trading memory for loss.
+ */
+
+#ifndef PIPELINE_SIZER_H
+#define PIPELINE_SIZER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Pipeline settings, 0 or -1 leave the SDK defaults.
+ */
+struct PipelineOptions {
+	uint32_t bufferCount = 0;	//* Number of buffers
+	uint32_t bufferSize = 0;	//* Bytes per buffer
+	int threadPriority = -1;	//* Priority of the buffer handling thread
+	uint32_t maxBufferCount = 0;	//* Grow the count automatically up to this, 0 = fixed
+
+	bool IsDefault() const {
+		return bufferCount == 0 && bufferSize == 0 && threadPriority < 0 && maxBufferCount == 0;
+	}
+};
+
+class PipelineSizer {
+public:
+	/**
+	 * @param rateHz frame rate the pipeline is filled at
+	 * @param count buffers the pipeline has now
+	 * @param maxCount largest count to grow to
+	 */
+	PipelineSizer(double rateHz, uint32_t count, uint32_t maxCount) :
+			rateHz(rateHz), count(count), maxCount(maxCount) {
+	}
+
+	/**
+	 * Records how long the consumer stayed away from the pipeline between two retrievals.
+	 * Grows by at least half the current count so a slowly rising stall does not resize
+	 * the pipeline on every frame.
+	 * @return buffer count to switch to, 0 to keep the current one
+	 */
+	uint32_t Observe(double awayS) {
+		if (awayS <= longestStallS) {
+			return 0;
+		}
+		longestStallS = awayS;
+		uint32_t needed = (uint32_t) std::ceil(awayS * rateHz) + headroom;
+		if (needed <= count || count >= maxCount) {
+			return 0;
+		}
+		count = std::min(maxCount, std::max(needed, count + count / 2));
+		++resizes;
+		return count;
+	}
+
+	uint32_t GetCount() const {
+		return count;
+	}
+
+	uint32_t GetResizes() const {
+		return resizes;
+	}
+
+	/**
+	 * @return longest time between two retrievals seen so far [s]
+	 */
+	double GetLongestStallS() const {
+		return longestStallS;
+	}
+
+private:
+	static const uint32_t headroom = 2;	//* The buffer being filled and the one held by the consumer
+
+	double rateHz;
+	uint32_t count;
+	uint32_t maxCount;
+	uint32_t resizes = 0;
+	double longestStallS = 0.0;
+};
+
+#endif /* PIPELINE_SIZER_H */
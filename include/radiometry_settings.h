@@ -0,0 +1,141 @@
+/**
+ * @file   radiometry_settings.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Radiometric parameter setters that keep temperature tables up to date.
+ *
+ * CameraSerialSettings recalculates its conversion constants privately, so callers cannot tell
+ * when a temperature table has gone stale. Changing the parameters through RadiometrySettings
+ * forwards to the camera and bumps the parameter generation, which makes every TemperatureLut
+ * rebuild on the next frame. The commands are sent under the camera's serial mutex, so they
+ * do not interleave with the telemetry reads of a poller.
+ */
+
+#ifndef RADIOMETRY_SETTINGS_H
+#define RADIOMETRY_SETTINGS_H
+
+#include <mutex>
+#include "Camera.h"
+#include "temperature_lut.h"
+
+class RadiometrySettings : public TemperatureLutSource {
+public:
+	/**
+	 * Reads the current parameters from the camera once.
+	 * @param serialMutex serializes the commands on the camera's serial link, see CameraTelemetry
+	 */
+	RadiometrySettings(Camera *cam, mutex &serialMutex) : cam(cam), serialMutex(serialMutex) {
+		CameraSerialSettings *settings = cam->GetSettings();
+
+		params.emissivity = settings->GetEmissivity();
+		params.reflectedTemperatureC = settings->GetReflectedTemperatureC();
+		params.atmosphericTemperatureC = settings->GetAtmospericTemperatureC();
+		params.humidity = settings->GetHumidity();
+		params.distance = settings->GetDistance();
+		params.rangeMode = (int) settings->GetRangeMode();
+		params.lens = settings->GetCurrentLense();
+	}
+
+	void SetEmissivity(double value) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetEmissivity(value);
+		params.emissivity = value;
+		BumpGeneration();
+	}
+
+	void SetReflectedTemperatureC(double value) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetReflectedTemperatureC(value);
+		params.reflectedTemperatureC = value;
+		BumpGeneration();
+	}
+
+	void SetReflectedTemperatureK(double value) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetReflectedTemperatureK(value);
+		params.reflectedTemperatureC = value - 273.15;
+		BumpGeneration();
+	}
+
+	void SetAtmospericTemperatureC(double value) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetAtmospericTemperatureC(value);
+		params.atmosphericTemperatureC = value;
+		BumpGeneration();
+	}
+
+	void SetAtmosphericTemperatureK(double value) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetAtmosphericTemperatureK(value);
+		params.atmosphericTemperatureC = value - 273.15;
+		BumpGeneration();
+	}
+
+	void SetHumidity(double humidity) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetHumidity(humidity);
+		params.humidity = humidity;
+		BumpGeneration();
+	}
+
+	void SetDistance(double distance) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetDistance(distance);
+		params.distance = distance;
+		BumpGeneration();
+	}
+
+	void SetRangeMode(CameraSerialSettings::RangeModes range) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetRangeMode(range);
+		params.rangeMode = (int) range;
+		BumpGeneration();
+	}
+
+	void SetLens(string lens) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetLens(lens);
+		params.lens = lens;
+		BumpGeneration();
+	}
+
+	void SetRadiometryMode(bool value) {
+		lock_guard<mutex> lock(paramsMutex);
+		lock_guard<mutex> serialLock(serialMutex);
+		cam->GetSettings()->SetRadiometryMode(value);
+		BumpGeneration();
+	}
+
+	/**
+	 * @return the parameters last read or set, without talking to the camera
+	 */
+	RadiometricParameterSet GetParameters() {
+		lock_guard<mutex> lock(paramsMutex);
+		return params;
+	}
+
+protected:
+	void BuildLut(TemperatureLut &lut) {
+		// Held while building so no setter changes the SDK constants halfway through the table
+		lock_guard<mutex> lock(paramsMutex);
+		Camera *c = cam;
+		lut.Build(params, GetGeneration(), [c](uint16_t raw) { return c->CalculateTemperatureC(raw); });
+	}
+
+private:
+	Camera *cam;
+	mutex &serialMutex;
+	mutex paramsMutex;			//* Taken before serialMutex
+	RadiometricParameterSet params;
+};
+
+#endif /* RADIOMETRY_SETTINGS_H */
@@ -0,0 +1,273 @@
+/**
+ * @file   replay_source.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  FrameSource playing back a recording made with the raw output format.
+ *
+ * Frames are fed back with their recorded timestamps and temperatures, either paced by the
+ * recorded timestamps or as fast as possible. When looping, the timestamps and block IDs of
+ * every further pass continue after the end of the previous one so they keep increasing.
+ */
+
+#ifndef REPLAY_SOURCE_H
+#define REPLAY_SOURCE_H
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "frame_source.h"
+#include "frame_writer.h"
+
+/**
+ * How a recording is played back.
+ */
+struct ReplayOptions {
+	std::string path;
+	bool paced = true;				//* false = as fast as possible
+	bool loop = false;				//* Start over at the end of the recording
+	double timestampTicksPerSecond = 1e9;		//* Unit of the recorded timestamps
+};
+
+class ReplaySource : public FrameSource {
+public:
+	ReplaySource(const ReplayOptions &options) : options(options) {
+	}
+
+	virtual ~ReplaySource() {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+
+	/**
+	 * Opens the recording and reads the first frame header.
+	 * @return 0 on success, otherwise an errno value (EINVAL for an unknown format)
+	 */
+	int Open() {
+		fd = open(options.path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return errno;
+		}
+		RawFrameHeader first;
+		if (!ReadHeader(first)) {
+			return EINVAL;
+		}
+		headerSize = first.headerSize;
+		width = first.width;
+		height = first.height;
+		sensorTemperatureC = first.sensorTemperatureC;
+		housingTemperatureC = first.housingTemperatureC;
+		shutterTemperatureC = first.shutterTemperatureC;
+		frame.resize((size_t) width * height);
+
+		// The rate is estimated from the first two frames
+		RawFrameHeader second;
+		if (lseek(fd, FrameBytes(), SEEK_SET) >= 0 && ReadHeader(second)
+				&& second.timestamp > first.timestamp) {
+			speedHz = options.timestampTicksPerSecond / (second.timestamp - first.timestamp);
+			framePeriodTicks = second.timestamp - first.timestamp;
+		}
+		lseek(fd, 0, SEEK_SET);
+		return 0;
+	}
+
+	int GetResolutionX() {
+		return width;
+	}
+
+	int GetResolutionY() {
+		return height;
+	}
+
+	double GetCameraSpeedHz() {
+		return speedHz;
+	}
+
+	/**
+	 * @return sensor temperature recorded with the current frame
+	 */
+	double GetSensorTemperature() {
+		return sensorTemperatureC;
+	}
+
+	/**
+	 * @return housing temperature recorded with the current frame
+	 */
+	double GetHousingTemperature() {
+		return housingTemperatureC;
+	}
+
+	double GetShutterTemperature() {
+		return shutterTemperatureC;
+	}
+
+	bool GetBufferTemperatures(float &sensorC, float &housingC, float &shutterC) {
+		sensorC = sensorTemperatureC;
+		housingC = housingTemperatureC;
+		shutterC = shutterTemperatureC;
+		return true;
+	}
+
+	/**
+	 * Recordings do not carry radiometric parameters, temperatures assume T-linear raw values.
+	 */
+	TLinearRadiometry &GetRadiometry() {
+		return radiometry;
+	}
+
+	void StartAcquisition() {
+		start = std::chrono::steady_clock::now();
+		firstTimestamp = 0;
+		haveFirst = false;
+		loopOffset = 0;
+		blockIdOffset = 0;
+		acquiring = fd >= 0;
+	}
+
+	bool IsAcquiring() {
+		return acquiring;
+	}
+
+	const uint16_t *RetreiveBuffer() {
+		RawFrameHeader header;
+
+		while (acquiring) {
+			if (ReadHeader(header)) {
+				break;
+			}
+			if (!options.loop || !haveFirst) {
+				acquiring = false;
+				return NULL;
+			}
+			// Continue the timestamps one frame period and the block IDs one block after the end of this pass
+			loopOffset = timestamp + framePeriodTicks - firstTimestamp;
+			blockIdOffset = firstBlockId != 0 ? blockId + 1 - firstBlockId : 0;
+			lseek(fd, 0, SEEK_SET);
+		}
+		if (!acquiring || header.headerSize != headerSize || header.width != width || header.height != height
+				|| !ReadFully(frame.data(), frame.size() * sizeof(uint16_t))) {
+			acquiring = false;
+			return NULL;
+		}
+
+		if (!haveFirst) {
+			firstTimestamp = header.timestamp;
+			firstBlockId = header.blockId;
+			haveFirst = true;
+		}
+		timestamp = header.timestamp + loopOffset;
+		sensorTemperatureC = header.sensorTemperatureC;
+		housingTemperatureC = header.housingTemperatureC;
+		shutterTemperatureC = header.shutterTemperatureC;
+		flags = header.flags;
+		blockId = header.blockId != 0 ? header.blockId + blockIdOffset : 0;
+
+		if (options.paced) {
+			std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>((timestamp - firstTimestamp) / options.timestampTicksPerSecond)));
+		}
+		return frame.data();
+	}
+
+	/**
+	 * @return recorded timestamp of the current frame
+	 */
+	uint64_t GetBufferTimestamp() {
+		return timestamp;
+	}
+
+	/**
+	 * @return false, the next frame is read when asked for, even when paced
+	 */
+	bool IsLive() {
+		return false;
+	}
+
+	/**
+	 * @return block ID recorded with the current frame, counting on across loops, 0 before version 4
+	 */
+	uint64_t GetBufferBlockId() {
+		return blockId;
+	}
+
+	/**
+	 * @return flags recorded with the current frame
+	 */
+	uint32_t GetBufferFlags() {
+		return flags;
+	}
+
+	void ReleaseBuffer() {
+	}
+
+	void StopAcquisition() {
+		acquiring = false;
+	}
+
+private:
+	/**
+	 * Reads a header of any known version, fields an earlier version lacks are zeroed.
+	 * @return false at the end of the file or if the header is not valid
+	 */
+	bool ReadHeader(RawFrameHeader &header) {
+		const size_t common = rawFrameHeaderSizes[1];
+
+		memset(&header, 0, sizeof(header));
+		if (!ReadFully(&header, common) || memcmp(header.magic, "T2RF", 4) != 0
+				|| header.version < 1 || header.version > rawFrameVersion
+				|| header.headerSize != rawFrameHeaderSizes[header.version]) {
+			return false;
+		}
+		return ReadFully((char *) &header + common, header.headerSize - common);
+	}
+
+	off_t FrameBytes() const {
+		return headerSize + (off_t) width * height * sizeof(uint16_t);
+	}
+
+	bool ReadFully(void *buffer, size_t size) {
+		char *p = (char *) buffer;
+		while (size > 0) {
+			ssize_t n = read(fd, p, size);
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) {
+				return false;
+			}
+			p += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	ReplayOptions options;
+	int fd = -1;
+	size_t headerSize = sizeof(RawFrameHeader);
+	int width = 0;
+	int height = 0;
+	double speedHz = 0.0;
+	uint64_t framePeriodTicks = 0;
+	std::vector<uint16_t> frame;
+	TLinearRadiometry radiometry;
+	std::chrono::steady_clock::time_point start;
+	uint64_t firstTimestamp = 0;
+	uint64_t timestamp = 0;
+	uint64_t loopOffset = 0;
+	uint64_t firstBlockId = 0;		//* Recorded block ID of the first frame
+	uint64_t blockIdOffset = 0;		//* Added to the recorded block IDs in the current pass
+	bool haveFirst = false;
+	bool acquiring = false;
+	float sensorTemperatureC = 0.0f;
+	float housingTemperatureC = 0.0f;
+	float shutterTemperatureC = 0.0f;
+	uint32_t flags = 0;
+	uint64_t blockId = 0;
+};
+
+#endif /* REPLAY_SOURCE_H */
@@ -0,0 +1,360 @@
+/**
+ * @file   segment_recording.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Recordings split into preallocated, memory mapped segment files.
+ *
+ * A segment is a file of fixed size laid out as
+ *   SegmentHeader | frames from dataOffset on | SegmentIndexEntry per frame at indexOffset
+ * where every frame is a RawFrameHeader followed by the pixels, padded to frameBytes.
+ * SegmentFrameWriter allocates each segment up front and maps it, so a frame is two
+ * copies into the page cache and no system call. The index entry and then the frame count
+ * in the header are stored after the frame, so a reader, or the file left behind by a
+ * crash of the process, always sees complete frames. Data reaches the disk with the
+ * kernel's writeback and is synced when a segment is finished; a full segment is followed
+ * by the next one, path-0000.ext, path-0001.ext and so on. A finished segment that is not
+ * full gets its index copied behind the last frame and is truncated there.
+ *
+ * A whole segment is mapped at once, so segments must fit the address space: the default
+ * size is smaller on 32 bit systems, where a free gigabyte of address space is rare.
+ *
+ * SegmentReader maps a segment read-only and gives random access to its frames, checking
+ * every index entry against the size of the file. A segment may be read while it is
+ * written, but finishing it truncates the file, and a reader touching the cut off pages
+ * gets SIGBUS. Readers of the segment being written have to be closed before the writer
+ * moves on to the next segment or is destroyed.
+ */
+
+#ifndef SEGMENT_RECORDING_H
+#define SEGMENT_RECORDING_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "frame_writer.h"
+
+/**
+ * First bytes of every segment. All fields are little-endian.
+ */
+struct SegmentHeader {
+	char magic[4];			//* "T2SG"
+	uint16_t version;		//* Format version, currently 1
+	uint16_t headerSize;		//* sizeof(SegmentHeader)
+	uint32_t segment;		//* Number of the segment in the recording, from 0
+	uint16_t width;			//* Pixels per row
+	uint16_t height;		//* Number of rows
+	uint64_t dataOffset;		//* Offset of the first frame
+	uint64_t frameBytes;		//* Distance between two frames: RawFrameHeader, pixels and padding
+	uint64_t frameCapacity;		//* Frames the segment was allocated for
+	uint64_t indexOffset;		//* Offset of the SegmentIndexEntry array
+	uint64_t frameCount;		//* Frames complete, stored after each frame
+	uint64_t reserved;
+};
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader must not contain padding");
+
+/**
+ * Footer entry of one frame.
+ */
+struct SegmentIndexEntry {
+	uint64_t offset;		//* Offset of the frame's RawFrameHeader in the segment
+	uint64_t frameId;		//* FrameSlot::id
+	uint64_t timestamp;		//* FrameSlot::timestamp
+	uint64_t hostTimestamp;		//* FrameSlot::hostTimestamp
+};
+static_assert(sizeof(SegmentIndexEntry) == 32, "SegmentIndexEntry must not contain padding");
+
+static const uint16_t segmentVersion = 1;
+static const uint64_t segmentDataOffset = 4096;	//* Frames start on a page of their own
+static const uint64_t defaultSegmentBytes = sizeof(void *) < 8 ? 256ull << 20 : 1ull << 30;
+
+/**
+ * @return true if a segment of the given size can be allocated and mapped as a whole
+ */
+inline bool isMappableSegmentSize(uint64_t bytes) {
+	return bytes <= SIZE_MAX && bytes <= (uint64_t) std::numeric_limits<off_t>::max();
+}
+
+/**
+ * Path of segment i of a recording: "-NNNN" inserted before the extension.
+ */
+std::string segmentPath(const std::string &path, uint32_t index) {
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of('/');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+		dot = path.size();
+	}
+	char number[16];
+	snprintf(number, sizeof(number), "-%04u", index);
+	return path.substr(0, dot) + number + path.substr(dot);
+}
+
+class SegmentFrameWriter : public FrameWriter {
+public:
+	/**
+	 * @param path recording path the segment numbers are inserted into
+	 * @param segmentBytes size every segment is allocated with, writing fails with EFBIG
+	 *        unless isMappableSegmentSize()
+	 */
+	SegmentFrameWriter(const std::string &path, uint64_t segmentBytes, int width, int height) :
+			FrameWriter(-1), path(path), segmentBytes(segmentBytes) {
+		initRawFrameHeader(header, width, height);
+		frameBytes = (sizeof(RawFrameHeader) + (uint64_t) width * height * sizeof(uint16_t) + 7) & ~(uint64_t) 7;
+		capacity = segmentBytes > segmentDataOffset
+				? (segmentBytes - segmentDataOffset) / (frameBytes + sizeof(SegmentIndexEntry)) : 0;
+	}
+
+	~SegmentFrameWriter() {
+		Finish();
+	}
+
+	/**
+	 * Copies the frame into the current segment, starting the next one when it is full.
+	 * Failures are reported by the following Flush().
+	 */
+	void Encode(const FrameSlot &frame) {
+		if (segment == NULL || segment->frameCount == segment->frameCapacity) {
+			Finish();
+			if (!Begin()) {
+				SetError(errno);
+				return;
+			}
+		}
+		uint64_t n = segment->frameCount;
+		uint64_t offset = segment->dataOffset + n * frameBytes;
+		char *p = (char *) segment + offset;
+
+		encodeRawFrameHeader(header, frame);
+		memcpy(p, &header, sizeof(header));
+		memcpy(p + sizeof(header), frame.pixels.data(), frame.pixels.size() * sizeof(uint16_t));
+
+		SegmentIndexEntry &entry = Index()[n];
+		entry.offset = offset;
+		entry.frameId = frame.id;
+		entry.timestamp = frame.timestamp;
+		entry.hostTimestamp = frame.hostTimestamp;
+
+		// Readers mapping the segment must not see the count before the frame
+		std::atomic_thread_fence(std::memory_order_release);
+		segment->frameCount = n + 1;
+		AddBytesWritten(frameBytes + sizeof(SegmentIndexEntry));
+	}
+
+	/**
+	 * @return number of segments started so far
+	 */
+	uint32_t GetSegmentCount() const {
+		return segments;
+	}
+
+private:
+	/**
+	 * Creates, allocates and maps the next segment.
+	 * @return false with errno set if that failed
+	 */
+	bool Begin() {
+		if (capacity == 0) {
+			errno = EINVAL;
+			return false;
+		}
+		if (!isMappableSegmentSize(segmentBytes)) {
+			errno = EFBIG;
+			return false;
+		}
+		std::string name = segmentPath(path, segments);
+		segmentFd = open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (segmentFd < 0) {
+			return false;
+		}
+		int error = posix_fallocate(segmentFd, 0, (off_t) segmentBytes);
+		void *mapping = error == 0
+				? mmap(NULL, (size_t) segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, segmentFd, 0) : MAP_FAILED;
+		if (mapping == MAP_FAILED) {
+			error = error != 0 ? error : errno;
+			close(segmentFd);
+			segmentFd = -1;
+			errno = error;
+			return false;
+		}
+		madvise(mapping, (size_t) segmentBytes, MADV_SEQUENTIAL);
+
+		segment = (SegmentHeader *) mapping;
+		memset(segment, 0, sizeof(SegmentHeader));
+		memcpy(segment->magic, "T2SG", 4);
+		segment->version = segmentVersion;
+		segment->headerSize = sizeof(SegmentHeader);
+		segment->segment = segments++;
+		segment->width = header.width;
+		segment->height = header.height;
+		segment->dataOffset = segmentDataOffset;
+		segment->frameBytes = frameBytes;
+		segment->frameCapacity = capacity;
+		segment->indexOffset = segmentDataOffset + capacity * frameBytes;
+		AddBytesWritten(segmentDataOffset);
+		return true;
+	}
+
+	/**
+	 * Syncs and closes the current segment and cuts off its unused tail. The index of one
+	 * that is not full is copied behind the last frame, synced, and only then the header
+	 * pointed at the copy, so the header always points at a complete index. Where the copy
+	 * would overlap the index, the unused frame space is smaller than the index and the
+	 * index stays where it is. Readers still mapping the segment must be closed first, see
+	 * the file comment.
+	 */
+	void Finish() {
+		if (segment == NULL) {
+			return;
+		}
+		uint64_t n = segment->frameCount;
+		uint64_t indexBytes = n * sizeof(SegmentIndexEntry);
+		uint64_t indexOffset = segment->dataOffset + n * frameBytes;
+		if (indexOffset + indexBytes <= segment->indexOffset) {
+			memcpy((char *) segment + indexOffset, Index(), indexBytes);
+			msync(segment, (size_t) segmentBytes, MS_SYNC);
+			segment->indexOffset = indexOffset;
+		}
+		uint64_t end = segment->indexOffset + indexBytes;
+		if (msync(segment, (size_t) segmentBytes, MS_SYNC) != 0) {
+			SetError(errno);
+		}
+		munmap(segment, (size_t) segmentBytes);
+		segment = NULL;
+		if (ftruncate(segmentFd, (off_t) end) != 0 || close(segmentFd) != 0) {
+			SetError(errno);
+		}
+		segmentFd = -1;
+	}
+
+	SegmentIndexEntry *Index() {
+		return (SegmentIndexEntry *) ((char *) segment + segment->indexOffset);
+	}
+
+	std::string path;
+	uint64_t segmentBytes;			//* Checked by Begin() to fit size_t and off_t
+	uint64_t frameBytes;
+	uint64_t capacity;			//* Frames per segment
+	RawFrameHeader header;
+	SegmentHeader *segment = NULL;		//* Mapping of the current segment
+	uint32_t segments = 0;
+	int segmentFd = -1;			//* Descriptor of the current segment, FrameWriter::fd is unused
+};
+
+class SegmentReader {
+public:
+	SegmentReader(const std::string &path) : path(path) {
+	}
+
+	~SegmentReader() {
+		if (segment != NULL) {
+			munmap((void *) segment, (size_t) size);
+		}
+	}
+
+	SegmentReader(const SegmentReader &) = delete;
+	SegmentReader &operator=(const SegmentReader &) = delete;
+
+	/**
+	 * Maps the segment and checks that its header, frames and index lie within the file.
+	 * @return 0 on success, EFBIG if the file does not fit the address space, else an
+	 *         errno value
+	 */
+	int Open() {
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return errno;
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0 || (uint64_t) st.st_size < sizeof(SegmentHeader)) {
+			close(fd);
+			return EINVAL;
+		}
+		if ((uint64_t) st.st_size > SIZE_MAX) {
+			close(fd);
+			return EFBIG;
+		}
+		size = st.st_size;
+		void *mapping = mmap(NULL, (size_t) size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapping == MAP_FAILED) {
+			return errno;
+		}
+		segment = (const SegmentHeader *) mapping;
+		frameSize = sizeof(RawFrameHeader) + (uint64_t) segment->width * segment->height * sizeof(uint16_t);
+		uint64_t frames = GetFrameCount();
+		if (memcmp(segment->magic, "T2SG", 4) != 0 || segment->version > segmentVersion
+				|| segment->frameBytes < frameSize
+				|| segment->dataOffset < sizeof(SegmentHeader) || segment->dataOffset > size
+				|| segment->indexOffset > size
+				|| frames > (size - segment->dataOffset) / segment->frameBytes
+				|| frames > (size - segment->indexOffset) / sizeof(SegmentIndexEntry)) {
+			return EINVAL;
+		}
+		return 0;
+	}
+
+	const SegmentHeader &GetHeader() const {
+		return *segment;
+	}
+
+	/**
+	 * @return frames complete at the time of the call, grows while the segment is written
+	 */
+	uint64_t GetFrameCount() const {
+		uint64_t frames = ((const volatile SegmentHeader *) segment)->frameCount;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return frames < segment->frameCapacity ? frames : segment->frameCapacity;
+	}
+
+	/**
+	 * @return index entry of frame i, NULL if the frame is not complete or the entry lies
+	 *         outside the file
+	 */
+	const SegmentIndexEntry *GetIndexEntry(uint64_t i) const {
+		if (i >= GetFrameCount() || i >= (size - segment->indexOffset) / sizeof(SegmentIndexEntry)) {
+			return NULL;
+		}
+		return (const SegmentIndexEntry *) ((const char *) segment + segment->indexOffset) + i;
+	}
+
+	/**
+	 * @return header of frame i, NULL if its index entry is missing, points outside the
+	 *         frames of the file or at a frame of another size
+	 */
+	const RawFrameHeader *GetFrameHeader(uint64_t i) const {
+		const SegmentIndexEntry *entry = GetIndexEntry(i);
+		if (entry == NULL || entry->offset < segment->dataOffset || entry->offset > size
+				|| size - entry->offset < frameSize) {
+			return NULL;
+		}
+		const RawFrameHeader *header = (const RawFrameHeader *) ((const char *) segment + entry->offset);
+		if (header->width != segment->width || header->height != segment->height) {
+			return NULL;
+		}
+		return header;
+	}
+
+	/**
+	 * @return row-major pixels of frame i, valid as long as the reader, NULL where
+	 *         GetFrameHeader() is
+	 */
+	const uint16_t *GetPixels(uint64_t i) const {
+		const RawFrameHeader *header = GetFrameHeader(i);
+		return header != NULL ? (const uint16_t *) ((const char *) header + sizeof(RawFrameHeader)) : NULL;
+	}
+
+private:
+	std::string path;
+	const SegmentHeader *segment = NULL;
+	uint64_t size = 0;			//* Mapped length
+	uint64_t frameSize = 0;			//* RawFrameHeader and pixels of one frame
+};
+
+#endif /* SEGMENT_RECORDING_H */
@@ -0,0 +1,354 @@
+/**
+ * @file   simulated_camera.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Synthetic camera for running and timing the capture path without hardware.
+ *
+ * Frames are 14-bit raw values in the Tau2 T-linear scale (0.04 K per count): a static
+ * gradient background, hot spots moving across the scene, per pixel noise and an offset
+ * step at every simulated flat field correction, during which the image is frozen as on
+ * the real camera. FFC runs periodically or, in manual mode, on PerformFFC(). Frames are
+ * paced at the configured rate, or produced as fast as possible for throughput
+ * measurements. Paced frames can wait in a pipeline of bounded depth which, like the
+ * PvPipeline, loses the frames arriving while it is full.
+ */
+
+#ifndef SIMULATED_CAMERA_H
+#define SIMULATED_CAMERA_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "frame_source.h"
+
+/**
+ * Scene and timing of a SimulatedCamera.
+ */
+struct SimulationOptions {
+	int width = 640;
+	int height = 512;
+	double rateHz = 30.0;
+	bool paced = true;			//* false = produce frames as fast as possible
+	int hotSpots = 3;
+	int noiseCounts = 8;			//* Peak amplitude of the uniform pixel noise
+	double ffcPeriodS = 60.0;		//* Simulated time between FFC events, 0 = never
+	double ffcDurationS = 0.5;		//* Time the image stays frozen during FFC
+	int ffcStepCounts = 40;			//* Offset change after each FFC
+	double sceneTemperatureC = 20.0;
+	double sensorTemperatureC = 35.0;
+	double housingTemperatureC = 30.0;
+	uint32_t seed = 1;			//* Noise generator seed
+	uint32_t pipelineBuffers = 0;		//* Frames waiting for retrieval before new ones are lost, 0 = unbounded
+};
+
+class SimulatedCamera : public FrameSource {
+public:
+	static constexpr double kelvinPerCount = TLinearRadiometry::kelvinPerCount;
+
+	SimulatedCamera(const SimulationOptions &options) : options(options),
+			background((size_t) options.width * options.height), frame(background.size()),
+			rng(options.seed != 0 ? options.seed : 1), radiometry(options.sceneTemperatureC),
+			pipelineBuffers(options.pipelineBuffers) {
+		// Scene temperature plus 8 K from left to right and 3 K from top to bottom
+		double base = TLinearRadiometry::TemperatureToRaw(options.sceneTemperatureC);
+		for (int y = 0; y < options.height; ++y) {
+			for (int x = 0; x < options.width; ++x) {
+				background[(size_t) y * options.width + x] = (int32_t) (base
+						+ 8.0 / kelvinPerCount * x / options.width + 3.0 / kelvinPerCount * y / options.height);
+			}
+		}
+	}
+
+	int GetResolutionX() {
+		return options.width;
+	}
+
+	int GetResolutionY() {
+		return options.height;
+	}
+
+	double GetCameraSpeedHz() {
+		return options.rateHz;
+	}
+
+	/**
+	 * Sensor temperature drifting slowly with simulated time.
+	 */
+	double GetSensorTemperature() {
+		return options.sensorTemperatureC + 0.5 * std::sin(SimulatedTimeS() / 300.0);
+	}
+
+	double GetHousingTemperature() {
+		return options.housingTemperatureC + 0.3 * std::sin(SimulatedTimeS() / 300.0);
+	}
+
+	/**
+	 * Shutter following the housing half a degree warmer.
+	 */
+	double GetShutterTemperature() {
+		return GetHousingTemperature() + 0.5;
+	}
+
+	TLinearRadiometry &GetRadiometry() {
+		return radiometry;
+	}
+
+	/**
+	 * Only the buffer count applies to the simulated pipeline.
+	 */
+	bool ConfigurePipeline(const PipelineOptions &options) {
+		if (options.bufferCount > 0) {
+			pipelineBuffers = options.bufferCount;
+		}
+		return true;
+	}
+
+	uint32_t GetPipelineBufferCount() {
+		return pipelineBuffers;
+	}
+
+	bool SetPipelineBufferCount(uint32_t count) {
+		pipelineBuffers = count;
+		return true;
+	}
+
+	void StartAcquisition() {
+		start = std::chrono::steady_clock::now();
+		frameIndex = 0;
+		lostFrames = 0;
+		skipPending = false;
+		acquiring = true;
+	}
+
+	bool IsAcquiring() {
+		return acquiring;
+	}
+
+	const uint16_t *RetreiveBuffer() {
+		if (!acquiring) {
+			return NULL;
+		}
+		if (options.paced) {
+			SkipLostFrames();
+			std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>(frameIndex / options.rateHz)));
+		}
+		double t = frameIndex / options.rateHz;
+		timestamp = (uint64_t) (t * 1e9);
+		frozen = UpdateFFC(t);
+		if (!frozen) {
+			Render(t);
+		}
+		++frameIndex;
+		return frame.data();
+	}
+
+	/**
+	 * @return simulated acquisition time of the current frame in nanoseconds
+	 */
+	uint64_t GetBufferTimestamp() {
+		return timestamp;
+	}
+
+	/**
+	 * @return false when producing frames as fast as possible
+	 */
+	bool IsLive() {
+		return options.paced;
+	}
+
+	/**
+	 * @return frame number counted from 1, like GigE Vision block IDs
+	 */
+	uint64_t GetBufferBlockId() {
+		return frameIndex;
+	}
+
+	/**
+	 * @return frameFlagFFC while the image is frozen
+	 */
+	uint32_t GetBufferFlags() {
+		return frozen ? frameFlagFFC : 0;
+	}
+
+	void ReleaseBuffer() {
+	}
+
+	void StopAcquisition() {
+		acquiring = false;
+	}
+
+	/**
+	 * In manual mode the periodic FFC schedule is replaced by PerformFFC().
+	 */
+	bool SetManualFFC(bool manual) {
+		manualFFC = manual;
+		return true;
+	}
+
+	/**
+	 * Requests an FFC at the next frame and waits until the image is no longer frozen,
+	 * or for the FFC duration plus a second if frames stop being retrieved.
+	 */
+	bool PerformFFC() {
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+				+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+						std::chrono::duration<double>(options.ffcDurationS + 1.0));
+		uint64_t before = ffcCount;
+		ffcRequested = true;
+		while (acquiring && (ffcCount == before || ffcActive) && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return ffcCount != before && !ffcActive;
+	}
+
+	/**
+	 * @return number of FFC events simulated so far
+	 */
+	uint64_t GetFFCCount() const {
+		return ffcCount;
+	}
+
+	/**
+	 * @return frames lost to a full simulated pipeline
+	 */
+	uint64_t GetLostFrames() const {
+		return lostFrames;
+	}
+
+	/**
+	 * Reports the frames delivered and lost by the simulated pipeline like the block
+	 * counts of a Pleora stream.
+	 */
+	bool ReadTransportStatistics(TransportStatistics &statistics) {
+		uint64_t lost = lostFrames;
+		statistics.transport = "simulated";
+		statistics.values.clear();
+		statistics.values.push_back(std::make_pair(std::string("BlockCount"), (double) (frameIndex - lost)));
+		statistics.values.push_back(std::make_pair(std::string("BlocksDropped"), (double) lost));
+		return true;
+	}
+
+private:
+	/**
+	 * When more frames have arrived than the pipeline holds, the buffered ones are still
+	 * delivered and the ones after them up to now are lost.
+	 */
+	void SkipLostFrames() {
+		uint32_t buffers = pipelineBuffers;
+		uint64_t index = frameIndex;
+		if (skipPending && index >= resumeFrom) {
+			lostFrames += resumeAt - index;
+			index = resumeAt;
+			skipPending = false;
+		}
+		if (buffers > 0 && !skipPending) {
+			uint64_t arrived = (uint64_t) (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+					* options.rateHz) + 1;
+			if (arrived > index + buffers) {
+				resumeFrom = index + buffers;
+				resumeAt = arrived;
+				skipPending = true;
+			}
+		}
+		frameIndex = index;
+	}
+
+	double SimulatedTimeS() const {
+		return frameIndex / options.rateHz;
+	}
+
+	/**
+	 * Tracks the FFC schedule.
+	 * @return true while the image is frozen
+	 */
+	bool UpdateFFC(double t) {
+		if (manualFFC) {
+			if (ffcRequested.exchange(false)) {
+				ffcStartS = t;
+				StepOffset(ffcCount + 1);
+				++ffcCount;
+			}
+			ffcActive = ffcCount > 0 && t - ffcStartS < options.ffcDurationS;
+			return ffcActive;
+		}
+		if (options.ffcPeriodS <= 0.0 || t < options.ffcPeriodS) {
+			return false;
+		}
+		uint64_t event = (uint64_t) (t / options.ffcPeriodS);
+		if (event != ffcCount) {
+			StepOffset(event);
+			ffcCount = event;
+		}
+		return t - event * options.ffcPeriodS < options.ffcDurationS;
+	}
+
+	void StepOffset(uint64_t event) {
+		// Alternate the sign so the offset stays bounded over long runs
+		offset += (event % 2 ? 1 : -1) * options.ffcStepCounts;
+	}
+
+	void Render(double t) {
+		const int w = options.width;
+		const int h = options.height;
+		const int noiseSpan = 2 * options.noiseCounts + 1;
+
+		for (size_t i = 0; i < frame.size(); ++i) {
+			// xorshift32
+			rng ^= rng << 13;
+			rng ^= rng >> 17;
+			rng ^= rng << 5;
+			int32_t noise = (int32_t) (((rng >> 24) * noiseSpan) >> 8) - options.noiseCounts;
+			frame[i] = Clamp14(background[i] + offset + noise);
+		}
+
+		// Hot spots 40 K above the scene on Lissajous paths
+		const int radius = h / 16 + 1;
+		const int32_t hot = (int32_t) (40.0 / kelvinPerCount);
+		for (int s = 0; s < options.hotSpots; ++s) {
+			int cx = (int) (w / 2 + (w / 2 - radius) * std::sin(t * (0.3 + 0.1 * s) + s));
+			int cy = (int) (h / 2 + (h / 2 - radius) * std::cos(t * (0.2 + 0.07 * s) + 2 * s));
+			for (int y = std::max(0, cy - radius); y < std::min(h, cy + radius); ++y) {
+				for (int x = std::max(0, cx - radius); x < std::min(w, cx + radius); ++x) {
+					int dx = x - cx;
+					int dy = y - cy;
+					if (dx * dx + dy * dy <= radius * radius) {
+						size_t i = (size_t) y * w + x;
+						frame[i] = Clamp14(frame[i] + hot);
+					}
+				}
+			}
+		}
+	}
+
+	static uint16_t Clamp14(int32_t value) {
+		return value < 0 ? 0 : (value > 0x3FFF ? 0x3FFF : value);
+	}
+
+	SimulationOptions options;
+	std::vector<int32_t> background;
+	std::vector<uint16_t> frame;
+	std::chrono::steady_clock::time_point start;
+	std::atomic<uint64_t> frameIndex{0};	//* Also read by the telemetry poller
+	uint64_t timestamp = 0;
+	std::atomic<uint64_t> ffcCount{0};
+	std::atomic<bool> manualFFC{false};
+	std::atomic<bool> ffcRequested{false};
+	std::atomic<bool> ffcActive{false};	//* A manual FFC is running
+	double ffcStartS = 0.0;
+	bool frozen = false;
+	int32_t offset = 0;
+	uint32_t rng;
+	std::atomic<bool> acquiring{false};
+	TLinearRadiometry radiometry;
+	std::atomic<uint32_t> pipelineBuffers;
+	std::atomic<uint64_t> lostFrames{0};	//* Also read for the transport statistics
+	bool skipPending = false;		//* Frames resumeFrom up to resumeAt were lost
+	uint64_t resumeFrom = 0;
+	uint64_t resumeAt = 0;
+};
+
+#endif /* SIMULATED_CAMERA_H */
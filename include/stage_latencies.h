@@ -0,0 +1,188 @@
+/**
+ * @file   stage_latencies.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Latency histograms of the capture path stages and their periodic report.
+ *
+ * The acquisition thread records how long it waited for a buffer and took to copy it,
+ * the output thread how long a frame sat in the ring and the time spent in each writer
+ * stage. All durations come from the steady clock. LatencyReporter prints p50, p99, p99.9
+ * and max of every stage for each interval, to standard error or appended to a file.
+ */
+
+#ifndef STAGE_LATENCIES_H
+#define STAGE_LATENCIES_H
+
+#include <chrono>
+#include <condition_variable>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "latency_histogram.h"
+
+/**
+ * Stages of the capture path, in the order a frame passes them.
+ */
+enum class CaptureStage {
+	Retrieve,	//* Waiting in RetreiveBuffer() of the source
+	Copy,		//* Masking the buffer into a ring slot
+	Queue,		//* From retrieval until the output thread takes the frame
+	Convert,	//* FrameWriter::Convert()
+	Encode,		//* FrameWriter::Encode()
+	Write		//* FrameWriter::Flush()
+};
+
+static const int captureStageCount = 6;
+static const char *const captureStageNames[] = { "retrieve", "copy", "queue", "convert", "encode", "write" };
+
+class StageLatencies {
+public:
+	void Record(CaptureStage stage, std::chrono::steady_clock::duration duration) {
+		histograms[(int) stage].Record(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+	}
+
+	std::vector<LatencySnapshot> Snapshot() const {
+		std::vector<LatencySnapshot> snapshots;
+		for (int s = 0; s < captureStageCount; ++s) {
+			snapshots.push_back(histograms[s].Snapshot());
+		}
+		return snapshots;
+	}
+
+private:
+	LatencyHistogram histograms[captureStageCount];
+};
+
+/**
+ * Writes one line per stage that saw frames: "<label>Latency <stage>: n=.. p50=.. ..." in µs.
+ * @param scope what the numbers cover, e.g. "last 1 s" or "total"
+ */
+void formatStageLatencies(std::ostream &out, const std::string &label, const std::string &scope,
+		const std::vector<LatencySnapshot> &snapshots) {
+	for (int s = 0; s < captureStageCount; ++s) {
+		const LatencySnapshot &snapshot = snapshots[s];
+		uint64_t count = snapshot.GetCount();
+		if (count == 0) {
+			continue;
+		}
+		out << label << "Latency " << captureStageNames[s] << " (" << scope << "): n=" << count
+				<< " p50=" << snapshot.GetPercentileNs(50.0) / 1e3
+				<< " p99=" << snapshot.GetPercentileNs(99.0) / 1e3
+				<< " p99.9=" << snapshot.GetPercentileNs(99.9) / 1e3
+				<< " max=" << snapshot.maxNs / 1e3 << " us" << std::endl;
+	}
+}
+
+class LatencyReporter {
+public:
+	/**
+	 * @param path file the reports are appended to, empty for standard error
+	 * @param label prefix of every line
+	 */
+	LatencyReporter(const StageLatencies &latencies, double intervalS, const std::string &path,
+			const std::string &label) : latencies(latencies), intervalS(intervalS), path(path), label(label) {
+	}
+
+	~LatencyReporter() {
+		Stop();
+	}
+
+	LatencyReporter(const LatencyReporter &) = delete;
+	LatencyReporter &operator=(const LatencyReporter &) = delete;
+
+	/**
+	 * @return false if the file cannot be opened
+	 */
+	bool Start() {
+		if (reporter.joinable()) {
+			return true;
+		}
+		if (!path.empty()) {
+			fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+			if (fd < 0) {
+				return false;
+			}
+		}
+		stopping = false;
+		previous = latencies.Snapshot();
+		reporter = std::thread(&LatencyReporter::Run, this);
+		return true;
+	}
+
+	/**
+	 * Stops the thread after reporting the interval in progress.
+	 */
+	void Stop() {
+		if (!reporter.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		reporter.join();
+		Report();
+		if (fd >= 0) {
+			close(fd);
+			fd = -1;
+		}
+	}
+
+private:
+	void Run() {
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		while (!wake.wait_for(lock, std::chrono::duration<double>(intervalS), [this] { return stopping; })) {
+			lock.unlock();
+			Report();
+			lock.lock();
+		}
+	}
+
+	/**
+	 * Writes the interval since the last report in one piece, so reports of streams running
+	 * in parallel do not interleave.
+	 */
+	void Report() {
+		std::vector<LatencySnapshot> current = latencies.Snapshot();
+		std::vector<LatencySnapshot> interval;
+		for (int s = 0; s < captureStageCount; ++s) {
+			interval.push_back(current[s].Since(previous[s]));
+		}
+		previous = current;
+
+		std::ostringstream scope;
+		scope << "last " << intervalS << " s";
+		std::ostringstream report;
+		formatStageLatencies(report, label, scope.str(), interval);
+		std::string text = report.str();
+		if (text.empty()) {
+			return;
+		}
+		if (fd >= 0) {
+			if (write(fd, text.data(), text.size()) < 0) {
+				// A failing stats file must not disturb the capture
+			}
+		} else {
+			std::cerr << text << std::flush;
+		}
+	}
+
+	const StageLatencies &latencies;
+	double intervalS;
+	std::string path;
+	std::string label;
+	int fd = -1;
+	std::vector<LatencySnapshot> previous;	//* Only used by the reporter thread, and by Stop() after it ended
+	std::thread reporter;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+};
+
+#endif /* STAGE_LATENCIES_H */
@@ -10,78 +10,1214 @@
 #ifndef TAU2_CAPTURE_H
 #define TAU2_CAPTURE_H
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sstream>
+#include <thread>
 #include "CameraCenter.h"
+#include "camera_frame_source.h"
+#include "camera_profile.h"
+#include "frame_aligner.h"
+#include "frame_kernels.h"
+#include "frame_ring.h"
+#include "frame_writer.h"
+#include "metrics_exporter.h"
+#include "replay_source.h"
+#include "segment_recording.h"
+#include "ffc_scheduler.h"
+#include "simulated_camera.h"
+#include "stage_latencies.h"
+#include "telemetry_poller.h"
+#include "transport_monitor.h"
 
-void retrieveFileHeader(Camera *cam) {
-	cout << "Camera part number: " << cam->GetSettings()->GetPartNumber() << endl;
-	cout << "Camera resolution: " << cam->GetSettings()->GetResolutionX() << "x" << cam->GetSettings()->GetResolutionY() << endl;
-	cout << "WIC model: " << cam->GetSettings()->GetModel() << endl;
-	cout << "Camera manufacture: " << cam->GetSettings()->GetManufacturer() << endl;
-	cout << "Camera firmware version: " << cam->GetSettings()->GetFWMajorVersion() << "-" << cam->GetSettings()->GetFWMinorVersion() << endl;
-	cout << "Camera sensor temperature [°C]: " << cam->GetSettings()->GetSensorTemperature() << endl; 
-	cout << "Camera housing temperature [°C]: " << cam->GetSettings()->GetHousingTemperature() << endl;
-	cout << "Check for camera speed: ";
-
-	switch(cam->GetSettings()->GetCameraSpeed()){
+/**
+ * Formats in which the pixel values are written.
+ */
+enum class OutputFormat {
+	Matrix,		//* Comma separated row-major matrix per frame
+	PixelList,	//* One "Row: y Column: x Raw: v" line per pixel
+	Celsius,	//* Comma separated matrix of temperatures in °C
+	Raw,		//* RawFrameHeader followed by the uint16 pixels
+	Segments	//* Raw frames in memory mapped segment files, see segment_recording.h
+};
+
+/**
+ * Command line options controlling how many frames are captured and where they go.
+ * With neither a frame count nor a duration a single frame is captured.
+ */
+struct CaptureOptions {
+	unsigned long frameCount = 0;	//* Number of frames to stream, 0 = unlimited
+	double durationS = 0.0;		//* Streaming duration in seconds, 0 = unlimited
+	size_t ringSlots = 16;		//* Frames buffered between acquisition and output
+	OutputFormat format = OutputFormat::Matrix;
+	string outputPath;		//* Output file, empty = standard output
+	uint64_t segmentBytes = defaultSegmentBytes;	//* Size of the segment files of OutputFormat::Segments
+	bool simulate = false;		//* Capture from a SimulatedCamera instead of hardware
+	SimulationOptions simulation;
+	bool replay = false;		//* Play back a raw recording instead of capturing
+	ReplayOptions replayOptions;
+	double telemetryMaxAgeS = 1.0;	//* Age after which camera temperatures are read again
+	double pollIntervalS = 0.0;	//* Temperature polling interval while streaming, 0 = every telemetryMaxAgeS
+	bool scheduleFFC = false;	//* Take over FFC timing with an FFCScheduler
+	bool allCameras = false;	//* Capture from every detected camera at once
+	bool synchronize = false;	//* Hardware synchronize all cameras and write aligned frames
+	AlignMode alignMode = AlignMode::BlockId;
+	PipelineOptions pipeline;
+	double latencyIntervalS = 0.0;	//* Interval of stage latency reports, 0 = not measured
+	string latencyPath;		//* File the latency reports are appended to, empty = standard error
+	string metricsTarget;		//* Metrics file or "unix:" socket path, empty = not exported
+	double metricsIntervalS = 5.0;	//* Interval the metrics file is rewritten at
+	double transportIntervalS = 0.0;	//* Transport statistics sampling interval, 0 = not sampled
+	string profilePath;		//* Camera profile applied after connecting, empty = none
+	vector<CameraProfileSetting> profile;	//* Settings loaded from profilePath
+	FFCScheduleOptions ffcSchedule;
+};
+
+/**
+ * Counters filled in by the acquisition thread, the atomic ones can be read while it runs.
+ */
+struct AcquisitionStats {
+	atomic<uint64_t> acquired{0};		//* Frames retrieved from the camera
+	atomic<uint64_t> timeouts{0};		//* Failed buffer retrievals
+	atomic<uint64_t> ffcDropped{0};		//* Frames dropped because they were captured during FFC
+	atomic<uint64_t> missingFrames{0};	//* Frames the block IDs show never arrived
+	atomic<uint64_t> incompleteFrames{0};	//* Frames with frameFlagsIncomplete bits
+	atomic<uint64_t> gaps{0};		//* Frames written with a gap before them
+	atomic<float> sensorTemperatureC{NAN};	//* Temperatures stamped on the latest frame
+	atomic<float> housingTemperatureC{NAN};
+	double elapsedS = 0.0;			//* Acquisition wall time, set when done
+	atomic<bool> done{false};	//* Set once the acquisition thread has finished
+};
+
+/**
+ * Helpers and shared state around streaming one source.
+ */
+struct StreamContext {
+	TelemetryPoller *poller = NULL;		//* Started poller whose snapshots are stamped on the frames
+	FFCScheduler *scheduler = NULL;		//* Started FFC scheduler
+	PipelineSizer *sizer = NULL;		//* Grows the source's pipeline, used by the acquisition thread only
+	StageLatencies *latencies = NULL;	//* Stage latencies to record, NULL = not measured
+	LatencyReporter *latencyReporter = NULL;
+	MetricsExporter *metrics = NULL;	//* Started exporter the stream registers its counters with
+	TransportMonitor *transport = NULL;	//* Samples the transport statistics of the source
+	size_t camera = 0;			//* Index of the camera in multi camera captures
+	chrono::steady_clock::time_point timeBase = chrono::steady_clock::now();	//* Zero of FrameSlot::hostTimestamp
+	string label;				//* Prefix of the summary lines
+};
+
+void printUsage(const char *name) {
+	cerr << "Usage: " << name << " [-n frames] [-t seconds] [-b slots] [-f matrix|list|celsius|raw|segments]" << endl;
+	cerr << "		[-o file] [-Z megabytes]" << endl;
+	cerr << "		[-s WIDTHxHEIGHT@HZ | -r file [-l]] [-a] [-T seconds] [-p seconds]" << endl;
+	cerr << "		[-F drift[,interval[,window[,gap]]] [-k]] [-m [-M block|time]]" << endl;
+	cerr << "		[-P count[,bytes[,priority]]] [-G count] [-L seconds[,file]]" << endl;
+	cerr << "		[-E file[,seconds] | -E unix:socket] [-S seconds] [-C profile]" << endl;
+	cerr << "	-n frames   stream the given number of frames" << endl;
+	cerr << "	-t seconds  stream for the given duration" << endl;
+	cerr << "	-b slots    frames buffered between acquisition and output (default 16)" << endl;
+	cerr << "	-f format   matrix (default) for comma separated rows, list for one" << endl;
+	cerr << "	            line per pixel, celsius for a matrix of temperatures, raw for" << endl;
+	cerr << "	            binary frames, segments for raw frames in preallocated memory" << endl;
+	cerr << "	            mapped files with a frame index, file-0000.ext, file-0001.ext..." << endl;
+	cerr << "	-o file     write frames to file instead of standard output" << endl;
+	cerr << "	-Z size     size of the segment files in megabytes (default " << (defaultSegmentBytes >> 20) << ")"
+			<< endl;
+	cerr << "	-s spec     capture from a simulated camera, e.g. 640x512@30" << endl;
+	cerr << "	-r file     play back a recording made with -f raw" << endl;
+	cerr << "	-l          loop the recording" << endl;
+	cerr << "	-a          simulate or play back as fast as possible instead of in real time" << endl;
+	cerr << "	-T seconds  maximum age of cached camera temperatures, while streaming" << endl;
+	cerr << "	            without -p they are polled at this interval (default 1)" << endl;
+	cerr << "	-p seconds  poll the temperatures in the background while streaming and" << endl;
+	cerr << "	            stamp every frame with the latest values" << endl;
+	cerr << "	-F spec     schedule flat field corrections: when the housing temperature" << endl;
+	cerr << "	            drifted by drift °C or after interval seconds, only between" << endl;
+	cerr << "	            measurement windows of window seconds, in the first gap seconds" << endl;
+	cerr << "	            after each window (default 1), e.g. 0.5,300,10,2" << endl;
+	cerr << "	-k          keep frames captured during FFC, tagged, instead of dropping them" << endl;
+	cerr << "	-m          capture from all detected cameras at once, camera i writes to" << endl;
+	cerr << "	            the -o file with -i inserted before the extension" << endl;
+	cerr << "	-M align    synchronize the cameras of -m, camera 0 as master, and write" << endl;
+	cerr << "	            only frames taken on the same pulse under the same frame id." << endl;
+	cerr << "	            Frames are matched by block ID or by host time; frames another" << endl;
+	cerr << "	            camera missed are flagged unmatched" << endl;
+	cerr << "	-P spec     frame buffers of the acquisition pipeline, bytes per buffer and" << endl;
+	cerr << "	            priority of its thread, 0 keeps the default, e.g. 32,0,2" << endl;
+	cerr << "	-G count    grow the pipeline up to count buffers to cover the longest" << endl;
+	cerr << "	            stalls of the acquisition thread seen while streaming" << endl;
+	cerr << "	-L spec     measure the latency of every capture stage and report p50, p99," << endl;
+	cerr << "	            p99.9 and max every interval, to standard error or appended" << endl;
+	cerr << "	            to the file, e.g. 10,latency.log" << endl;
+	cerr << "	-E target   export frame, drop, FFC, temperature, serial, queue and output" << endl;
+	cerr << "	            counters in the Prometheus text format to a file rewritten every" << endl;
+	cerr << "	            seconds (default 5), or to every client of a unix domain socket" << endl;
+	cerr << "	-S seconds  sample the statistics of the GigE Vision or USB3 Vision stream," << endl;
+	cerr << "	            e.g. lost blocks, resends and bandwidth, for -E and the summary" << endl;
+	cerr << "	-C profile  apply the camera settings in the file, one \"name value\" per" << endl;
+	cerr << "	            line, e.g. agc_type 1, see camera_profile.h" << endl;
+	cerr << "Without options a single frame is captured." << endl;
+}
+
+/**
+ * Parses an unsigned decimal number at the start of text, which strtoull() alone would
+ * also accept with a sign or leading blanks, negative numbers wrapped around.
+ * @param end set to the first character after the number
+ * @return false if text does not start with a digit or the number is larger than max
+ */
+bool parseUnsigned(const char *text, unsigned long long max, unsigned long long &value, char *&end) {
+	if (!isdigit((unsigned char) *text)) {
+		return false;
+	}
+	errno = 0;
+	value = strtoull(text, &end, 10);
+	return errno != ERANGE && value <= max;
+}
+
+/**
+ * Parses the command line into the capture options.
+ * @return false if the arguments are invalid
+ */
+bool parseCaptureOptions(int argc, char *argv[], CaptureOptions &opts) {
+	int opt;
+	char *end;
+
+	while ((opt = getopt(argc, argv, "n:t:b:f:o:Z:s:r:laT:p:F:kmM:P:G:L:E:S:C:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			opts.frameCount = strtoul(optarg, &end, 10);
+			if (*end != '\0' || opts.frameCount == 0) {
+				return false;
+			}
+			break;
+		case 't':
+			opts.durationS = strtod(optarg, &end);
+			if (*end != '\0' || opts.durationS <= 0.0) {
+				return false;
+			}
+			break;
+		case 'b':
+			opts.ringSlots = strtoul(optarg, &end, 10);
+			if (*end != '\0' || opts.ringSlots == 0) {
+				return false;
+			}
+			break;
+		case 'f':
+			if (strcmp(optarg, "matrix") == 0) {
+				opts.format = OutputFormat::Matrix;
+			} else if (strcmp(optarg, "list") == 0) {
+				opts.format = OutputFormat::PixelList;
+			} else if (strcmp(optarg, "celsius") == 0) {
+				opts.format = OutputFormat::Celsius;
+			} else if (strcmp(optarg, "raw") == 0) {
+				opts.format = OutputFormat::Raw;
+			} else if (strcmp(optarg, "segments") == 0) {
+				opts.format = OutputFormat::Segments;
+			} else {
+				return false;
+			}
+			break;
+		case 'o':
+			opts.outputPath = optarg;
+			break;
+		case 'Z': {
+			unsigned long long megabytes;
+			if (!parseUnsigned(optarg, UINT64_MAX >> 20, megabytes, end) || *end != '\0' || megabytes == 0
+					|| !isMappableSegmentSize((uint64_t) megabytes << 20)) {
+				return false;
+			}
+			opts.segmentBytes = (uint64_t) megabytes << 20;
+			break;
+		}
+		case 's':
+			if (sscanf(optarg, "%dx%d@%lf", &opts.simulation.width, &opts.simulation.height,
+					&opts.simulation.rateHz) != 3 || opts.simulation.width <= 0
+					|| opts.simulation.height <= 0 || opts.simulation.rateHz <= 0.0) {
+				return false;
+			}
+			opts.simulate = true;
+			break;
+		case 'r':
+			opts.replayOptions.path = optarg;
+			opts.replay = true;
+			break;
+		case 'l':
+			opts.replayOptions.loop = true;
+			break;
+		case 'a':
+			opts.simulation.paced = false;
+			opts.replayOptions.paced = false;
+			break;
+		case 'T':
+			opts.telemetryMaxAgeS = strtod(optarg, &end);
+			if (*end != '\0' || opts.telemetryMaxAgeS < 0.0) {
+				return false;
+			}
+			break;
+		case 'p':
+			opts.pollIntervalS = strtod(optarg, &end);
+			if (*end != '\0' || opts.pollIntervalS <= 0.0) {
+				return false;
+			}
+			break;
+		case 'F':
+			if (sscanf(optarg, "%lf,%lf,%lf,%lf", &opts.ffcSchedule.driftC, &opts.ffcSchedule.maxIntervalS,
+					&opts.ffcSchedule.windowS, &opts.ffcSchedule.gapS) < 1 || opts.ffcSchedule.driftC <= 0.0
+					|| opts.ffcSchedule.maxIntervalS < 0.0 || opts.ffcSchedule.windowS < 0.0
+					|| opts.ffcSchedule.gapS < 0.0) {
+				return false;
+			}
+			opts.scheduleFFC = true;
+			break;
+		case 'k':
+			opts.ffcSchedule.dropFrames = false;
+			break;
+		case 'm':
+			opts.allCameras = true;
+			break;
+		case 'M':
+			if (strcmp(optarg, "block") == 0) {
+				opts.alignMode = AlignMode::BlockId;
+			} else if (strcmp(optarg, "time") == 0) {
+				opts.alignMode = AlignMode::HostTimestamp;
+			} else {
+				return false;
+			}
+			opts.synchronize = true;
+			break;
+		case 'P': {
+			// Buffer count, buffer size and thread priority, the later ones optional
+			static const unsigned long long maxima[] = { UINT32_MAX, UINT32_MAX, INT_MAX };
+			unsigned long long values[3] = { 0, 0, 0 };
+			int fields = 0;
+			const char *field = optarg;
+			do {
+				if (fields == 3 || !parseUnsigned(field, maxima[fields], values[fields], end)
+						|| (*end != '\0' && *end != ',')) {
+					return false;
+				}
+				++fields;
+				field = end + 1;
+			} while (*end != '\0');
+			opts.pipeline.bufferCount = (uint32_t) values[0];
+			opts.pipeline.bufferSize = (uint32_t) values[1];
+			opts.pipeline.threadPriority = fields == 3 ? (int) values[2] : -1;
+			break;
+		}
+		case 'G':
+			opts.pipeline.maxBufferCount = strtoul(optarg, &end, 10);
+			if (*end != '\0' || opts.pipeline.maxBufferCount == 0) {
+				return false;
+			}
+			break;
+		case 'L':
+			opts.latencyIntervalS = strtod(optarg, &end);
+			if ((*end != '\0' && *end != ',') || opts.latencyIntervalS <= 0.0) {
+				return false;
+			}
+			opts.latencyPath = *end == ',' ? end + 1 : "";
+			break;
+		case 'E': {
+			opts.metricsTarget = optarg;
+			size_t comma = opts.metricsTarget.find_last_of(',');
+			if (comma != string::npos && opts.metricsTarget.compare(0, 5, "unix:") != 0) {
+				opts.metricsIntervalS = strtod(optarg + comma + 1, &end);
+				if (*end != '\0' || opts.metricsIntervalS <= 0.0) {
+					return false;
+				}
+				opts.metricsTarget.erase(comma);
+			}
+			if (opts.metricsTarget.empty() || opts.metricsTarget == "unix:") {
+				return false;
+			}
+			break;
+		}
+		case 'S':
+			opts.transportIntervalS = strtod(optarg, &end);
+			if (*end != '\0' || opts.transportIntervalS <= 0.0) {
+				return false;
+			}
+			break;
+		case 'C':
+			opts.profilePath = optarg;
+			break;
+		default:
+			return false;
+		}
+	}
+	if (opts.frameCount == 0 && opts.durationS == 0.0 && !opts.replay) {
+		opts.frameCount = 1;
+	}
+	return optind == argc && !(opts.simulate && opts.replay)
+			&& !(opts.allCameras && (opts.simulate || opts.replay || opts.outputPath.empty()))
+			&& (opts.allCameras || !opts.synchronize)
+			&& !(opts.format == OutputFormat::Segments && opts.outputPath.empty())
+			&& !(!opts.profilePath.empty() && (opts.simulate || opts.replay));
+}
+
+/**
+ * Applies the loaded camera profile as one serial batch and reports the settings the
+ * camera did not accept. The cached camera properties are read again afterwards, so the
+ * header shows the settings the profile changed.
+ * @return false if a setting failed
+ */
+bool applyCameraProfile(CameraFrameSource &source, const vector<CameraProfileSetting> &profile, ostream &out) {
+	if (profile.empty()) {
+		return true;
+	}
+	vector<Tau2Command> commands = cameraProfileCommands(profile);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	bool ok = source.ExecuteSerial(commands);
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	source.GetTelemetry().Reread();
+
+	for (size_t i = 0; i < commands.size(); ++i) {
+		if (!commands[i].answered) {
+			out << "Camera profile: " << profile[i].name << " not answered" << endl;
+		} else if (commands[i].status != Tau2Status::CAM_OK) {
+			out << "Camera profile: " << profile[i].name << " rejected with status " << (int) commands[i].status << endl;
+		}
+	}
+	out << "Camera profile: " << profile.size() << " settings " << (ok ? "applied" : "sent") << " in " << ms << " ms" << endl;
+	return ok;
+}
+
+/**
+ * Prints the camera properties and settings and runs a flat field correction. Everything
+ * except the temperatures was read once at connect, so printing costs no serial round
+ * trips beyond one telemetry snapshot.
+ */
+void retrieveFileHeader(CameraFrameSource &source, ostream &out = cout) {
+	const CameraInfo &camInfo = source.GetTelemetry().GetInfo();
+	CameraTelemetrySnapshot telemetry = source.GetTelemetry().Get();
+	RadiometricParameterSet params = source.GetRadiometry().GetParameters();
+
+	out << "Camera part number: " << camInfo.partNumber << endl;
+	out << "Camera resolution: " << camInfo.resolutionX << "x" << camInfo.resolutionY << endl;
+	out << "WIC model: " << camInfo.model << endl;
+	out << "Camera manufacture: " << camInfo.manufacturer << endl;
+	out << "Camera firmware version: " << camInfo.fwMajorVersion << "-" << camInfo.fwMinorVersion << endl;
+	out << "Camera sensor temperature [°C]: " << telemetry.sensorTemperatureC << endl; 
+	out << "Camera housing temperature [°C]: " << telemetry.housingTemperatureC << endl;
+	out << "Check for camera speed: ";
+
+	switch(camInfo.cameraSpeed){
 	case CameraSerialSettings::CameraSpeed::_9Hz:
-		cout << "9Hz" << endl;
+		out << "9Hz" << endl;
 		break;
 	case CameraSerialSettings::CameraSpeed::_30Hz:
-		cout << "30Hz" << endl;
+		out << "30Hz" << endl;
 		break;
 	case CameraSerialSettings::CameraSpeed::_60Hz:
-		cout << "60Hz" << endl;
+		out << "60Hz" << endl;
 		break;
 	default:
-		cout << "" << endl;
+		out << "" << endl;
 		break;
 	}
 
-	if (cam->GetSettings()->GetIsRadiometric()) {
-		cout << "Camera is capable of radiometry" << endl;
-		if (cam->GetSettings()->GetRadiometryMode()) {
-			cout << "	 -Camera is in radiometry mode" << endl;
+	if (camInfo.isRadiometric) {
+		out << "Camera is capable of radiometry" << endl;
+		if (camInfo.radiometryMode) {
+			out << "	 -Camera is in radiometry mode" << endl;
 		} else {
-			cout << "	 -Camera is not in radiometry mode" << endl;
+			out << "	 -Camera is not in radiometry mode" << endl;
 		}
 	} else {
-		cout << "	 -Camera is not capable of radiometry" << endl;
+		out << "	 -Camera is not capable of radiometry" << endl;
 	}
 
-	switch (cam->GetSettings()->GetTestPattern()) {
+	switch (camInfo.testPattern) {
 	case CameraSerialSettings::TestPatterns::Off:
-		cout << "Test patter is off" << endl;
+		out << "Test patter is off" << endl;
 		break;
 	default:
-		cout << "Test pattern is on" << endl;
+		out << "Test pattern is on" << endl;
 		break;
 	}
-	cout << "Temperature calculation values: " << endl;
-	cout << "	-Emissivity: " << cam->GetSettings()->GetEmissivity() << endl;
-	cout << "	-Atmospheric temperature [°C]: " << cam->GetSettings()->GetAtmospericTemperatureC() << endl;
-	cout << "	-Reflected temperature [°C]: " << cam->GetSettings()->GetReflectedTemperatureC() << endl;
-	cout << "	-Humidity [%]: " << cam->GetSettings()->GetHumidity() * 100.0 << endl;
-	cout << "	-Object distance [m]: " << cam->GetSettings()->GetDistance() << endl;
+	out << "Temperature calculation values: " << endl;
+	out << "	-Emissivity: " << params.emissivity << endl;
+	out << "	-Atmospheric temperature [°C]: " << params.atmosphericTemperatureC << endl;
+	out << "	-Reflected temperature [°C]: " << params.reflectedTemperatureC << endl;
+	out << "	-Humidity [%]: " << params.humidity * 100.0 << endl;
+	out << "	-Object distance [m]: " << params.distance << endl;
+
+	out << "Performing flat field correction (click noise)..." << endl;
+	if (!source.PerformFFC()) {
+		out << "Shutter position could not be read, waited for the flat field correction instead" << endl;
+	}
+}
+
+
+/**
+ * Number of block IDs skipped between two consecutive frames, counting across 16 bit wraps.
+ * A restarted stream, see isBlockIdWrap(), has nothing missing.
+ */
+uint64_t missingBlockIds(uint64_t previous, uint64_t current) {
+	if (current > previous) {
+		return current - previous - 1;
+	}
+	if (isBlockIdWrap(previous, current)) {
+		return 0xFFFF - previous + current - 1;
+	}
+	return 0;
+}
+
+/**
+ * Acquisition thread body. Owns RetreiveBuffer()/ReleaseBuffer(): every frame is copied
+ * (masked to 14 bits) into a free ring slot and the buffer is returned to the source
+ * immediately. When the ring is full a frame of a live source is dropped and counted as
+ * an overrun instead of waiting for the consumer; a source that is not live, a recording
+ * or an unpaced simulation, waits for a free slot since nothing is lost meanwhile.
+ * Frames are stamped with the temperatures the source recorded with them, else with the
+ * latest snapshot of the poller, else with the given values.
+ * Frames captured while the scheduler runs an FFC are dropped or tagged with frameFlagFFC.
+ * With a sizer the time spent away from the source between retrievals is measured and
+ * the source's pipeline grown when it would not have covered it.
+ * Frames skipped by the block IDs, retrieval timeouts and frames dropped here are counted
+ * and recorded as the gap of the next frame that makes it into the ring. Only frames that
+ * made it into the ring count towards -n, dropped ones still use up a frame id.
+ */
+void acquireFrames(FrameSource *source, const CaptureOptions &opts, FrameRing *ring, AcquisitionStats *stats,
+		const StreamContext *context, TemperatureSnapshot initial) {
+	typedef chrono::steady_clock Clock;
+	TelemetryPoller *poller = context->poller;
+	FFCScheduler *scheduler = context->scheduler;
+	PipelineSizer *sizer = context->sizer;
+	StageLatencies *latencies = context->latencies;
+	Clock::time_point start = Clock::now();
+	Clock::time_point lastRetrieved = start;
+	Clock::time_point deadline = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(opts.durationS));
+	bool live = source->IsLive();
+	uint64_t id = 0;
+	uint64_t committed = 0;
+	uint64_t lastBlockId = 0;
+	uint32_t gapFrames = 0;
+	uint32_t gapReasons = 0;
+
+	while (opts.frameCount == 0 || committed < opts.frameCount) {
+		stats->acquired.store(id, memory_order_relaxed);
+		if (opts.durationS > 0.0 && Clock::now() >= deadline) {
+			break;
+		}
+
+		Clock::time_point called = Clock::now();
+		const uint16_t *buffer = source->RetreiveBuffer();
+		Clock::time_point retrieved = Clock::now();
+		if (sizer != NULL && id > 0) {
+			uint32_t count = sizer->Observe(chrono::duration<double>(called - lastRetrieved).count());
+			if (count > 0) {
+				source->SetPipelineBufferCount(count);
+			}
+		}
+		lastRetrieved = retrieved;
+		if (buffer == NULL) {
+			if (!source->IsAcquiring()) {
+				break;
+			}
+			++stats->timeouts;
+			gapReasons |= gapReasonTimeout;
+			continue;
+		}
+		if (latencies != NULL) {
+			latencies->Record(CaptureStage::Retrieve, retrieved - called);
+		}
+
+		uint64_t blockId = source->GetBufferBlockId();
+		if (blockId != 0) {
+			uint64_t missing = lastBlockId != 0 ? missingBlockIds(lastBlockId, blockId) : 0;
+			if (missing > 0) {
+				stats->missingFrames += missing;
+				gapFrames += missing;
+				gapReasons |= gapReasonMissingBlocks;
+			}
+			lastBlockId = blockId;
+		}
+
+		uint32_t flags = source->GetBufferFlags();
+		if (flags & frameFlagsIncomplete) {
+			++stats->incompleteFrames;
+		}
+		if (scheduler != NULL && scheduler->TagFrame(flags)) {
+			source->ReleaseBuffer();
+			++stats->ffcDropped;
+			++gapFrames;
+			gapReasons |= gapReasonFFC;
+			++id;
+			continue;
+		}
+
+		while (!live && ring->GetSize() == ring->GetCapacity()) {
+			this_thread::sleep_for(chrono::microseconds(100));
+		}
+		FrameSlot *slot = ring->BeginWrite();
+		if (slot != NULL) {
+			slot->id = id;
+			slot->flags = flags;
+			slot->timestamp = source->GetBufferTimestamp();
+			slot->blockId = blockId;
+			slot->gapFrames = gapFrames;
+			slot->gapReasons = gapReasons;
+			if (gapReasons != 0) {
+				++stats->gaps;
+			}
+			gapFrames = 0;
+			gapReasons = 0;
+			slot->hostTimestamp = chrono::duration_cast<chrono::nanoseconds>(retrieved - context->timeBase).count();
+			if (!source->GetBufferTemperatures(slot->sensorTemperatureC, slot->housingTemperatureC,
+					slot->shutterTemperatureC)) {
+				shared_ptr<const TemperatureSnapshot> latest;
+				if (poller != NULL) {
+					latest = poller->GetSnapshot();
+				}
+				const TemperatureSnapshot &temperatures = latest ? *latest : initial;
+				slot->sensorTemperatureC = temperatures.sensorTemperatureC;
+				slot->housingTemperatureC = temperatures.housingTemperatureC;
+				slot->shutterTemperatureC = temperatures.shutterTemperatureC;
+			}
+			stats->sensorTemperatureC.store(slot->sensorTemperatureC, memory_order_relaxed);
+			stats->housingTemperatureC.store(slot->housingTemperatureC, memory_order_relaxed);
+			maskRaw14(buffer, slot->pixels.data(), slot->pixels.size());
+			ring->CommitWrite();
+			++committed;
+			if (latencies != NULL) {
+				latencies->Record(CaptureStage::Copy, Clock::now() - retrieved);
+			}
+		} else {
+			++gapFrames;
+			gapReasons |= gapReasonOverrun;
+		}
+		source->ReleaseBuffer();
+		++id;
+	}
+
+	stats->acquired = id;
+	stats->elapsedS = chrono::duration<double>(Clock::now() - start).count();
+	stats->done.store(true, memory_order_release);
+}
+
+/**
+ * @return the source's temperatures from one reading, for streams without a poller
+ */
+TemperatureSnapshot readTemperatures(FrameSource &source) {
+	TemperatureSnapshot temperatures;
+	double sensorC, housingC, shutterC;
+
+	source.GetTemperatures(sensorC, housingC, shutterC, false);
+	temperatures.sensorTemperatureC = sensorC;
+	temperatures.housingTemperatureC = housingC;
+	temperatures.shutterTemperatureC = shutterC;
+	return temperatures;
+}
+
+/**
+ * Reports the gap before a frame on standard error as the frame is written. After
+ * maxLoggedGaps gaps, e.g. from a persistently full ring, the rest are only counted.
+ * @param logged gaps logged so far on this stream
+ */
+void logGap(const StreamContext &context, const FrameSlot &frame, unsigned &logged) {
+	static const unsigned maxLoggedGaps = 20;
+
+	if (frame.gapReasons == 0 || logged > maxLoggedGaps) {
+		return;
+	}
+	ostringstream line;
+	if (++logged > maxLoggedGaps) {
+		line << context.label << "Further gaps are only counted" << endl;
+	} else {
+		line << context.label << "Gap before frame " << frame.id << " (block " << frame.blockId << "): "
+				<< frame.gapFrames << " frames missing";
+		if (frame.gapReasons & gapReasonMissingBlocks) {
+			line << ", block IDs skipped";
+		}
+		if (frame.gapReasons & gapReasonTimeout) {
+			line << ", retrieval timed out";
+		}
+		if (frame.gapReasons & gapReasonOverrun) {
+			line << ", ring overrun";
+		}
+		if (frame.gapReasons & gapReasonFFC) {
+			line << ", dropped during FFC";
+		}
+		line << endl;
+	}
+	cerr << line.str() << flush;
+}
+
+/**
+ * Writes a frame taken from the ring, timing each writer stage if latencies are measured.
+ * @return false if the output failed
+ */
+bool writeFrame(FrameWriter &writer, const FrameSlot &frame, const StreamContext &context) {
+	typedef chrono::steady_clock Clock;
+	StageLatencies *latencies = context.latencies;
+
+	if (latencies == NULL) {
+		return writer.Write(frame);
+	}
+	Clock::time_point t0 = Clock::now();
+	latencies->Record(CaptureStage::Queue, t0 - (context.timeBase + chrono::nanoseconds(frame.hostTimestamp)));
+	writer.Convert(frame);
+	Clock::time_point t1 = Clock::now();
+	writer.Encode(frame);
+	Clock::time_point t2 = Clock::now();
+	bool ok = writer.Flush();
+	Clock::time_point t3 = Clock::now();
+	latencies->Record(CaptureStage::Convert, t1 - t0);
+	latencies->Record(CaptureStage::Encode, t2 - t1);
+	latencies->Record(CaptureStage::Write, t3 - t2);
+	return ok;
+}
+
+/**
+ * Appends the acquisition and output counters of one stream to the summary, and the
+ * error that stopped the writer, if any.
+ */
+void summarizeStream(ostream &summary, const StreamContext &context, FrameSource &source,
+		const AcquisitionStats &stats, unsigned long written, FrameWriter &writer, FrameRing &ring) {
+	summary << context.label << "Acquired " << stats.acquired << " frames in " << stats.elapsedS << " s";
+	if (stats.elapsedS > 0.0) {
+		summary << " (" << stats.acquired / stats.elapsedS << " fps, camera runs at "
+				<< source.GetCameraSpeedHz() << " Hz)";
+	}
+	summary << endl;
+	summary << context.label << "Written " << written << " frames (" << writer.GetBytesWritten()
+			<< " bytes), ring overruns: " << ring.GetOverruns() << endl;
+	if (writer.GetError() != 0) {
+		summary << context.label << "Writing frames failed: " << strerror(writer.GetError()) << endl;
+	}
+	if (context.scheduler != NULL) {
+		summary << context.label << "Flat field corrections: " << context.scheduler->GetFFCCount()
+				<< ", frames dropped during FFC: " << stats.ffcDropped << endl;
+		if (context.scheduler->GetUnobservedFFCCount() > 0) {
+			summary << context.label << "End of FFC not observed, waited instead: "
+					<< context.scheduler->GetUnobservedFFCCount() << " times" << endl;
+		}
+	}
+	if (stats.timeouts > 0) {
+		summary << context.label << "Buffer retrieval failed " << stats.timeouts << " times" << endl;
+	}
+	if (stats.missingFrames > 0 || stats.incompleteFrames > 0 || stats.gaps > 0) {
+		summary << context.label << "Frames missing by block ID: " << stats.missingFrames << ", incomplete frames: "
+				<< stats.incompleteFrames << ", gaps recorded: " << stats.gaps << endl;
+	}
+	if (context.transport != NULL) {
+		// Read once more so the counts cover the whole stream
+		TransportStatistics statistics;
+		if (source.ReadTransportStatistics(statistics)) {
+			formatTransportStatistics(summary, context.label, statistics);
+		}
+	}
+	if (context.latencies != NULL) {
+		formatStageLatencies(summary, context.label, "total", context.latencies->Snapshot());
+	}
+	if (context.sizer != NULL) {
+		summary << context.label << "Pipeline buffers: " << source.GetPipelineBufferCount() << ", grown "
+				<< context.sizer->GetResizes() << " times, longest stall "
+				<< context.sizer->GetLongestStallS() * 1e3 << " ms" << endl;
+	}
+}
+
+/**
+ * Registers the live counters of one stream with the exporter, labelled with the camera
+ * index. The collector runs on the exporter thread and only reads atomics and snapshots,
+ * so a scrape never waits for a serial command such as an FFC. Transport statistics
+ * are exported as tau2_transport_<name> with the transport as label.
+ * @return id of the collector, to be removed before the stream's state goes away
+ */
+int addStreamMetrics(MetricsExporter &exporter, FrameSource &source, const AcquisitionStats &stats,
+		const FrameRing &ring, const FrameWriter &writer, const StreamContext &context) {
+	string camera = "camera=\"" + to_string(context.camera) + "\"";
+	FFCScheduler *scheduler = context.scheduler;
+	TransportMonitor *transport = context.transport;
+	FrameSource *from = &source;
+
+	return exporter.AddCollector([from, &stats, &ring, &writer, scheduler, transport, camera](MetricsText &text) {
+		text.Add("tau2_frames_acquired_total", "counter", "Frames retrieved from the camera.", camera,
+				stats.acquired.load(memory_order_relaxed));
+		text.Add("tau2_frames_written_total", "counter", "Frames written to the output.", camera,
+				writer.GetFramesWritten());
+		text.Add("tau2_frames_dropped_total", "counter", "Frames dropped or lost, by reason.",
+				camera + ",reason=\"missing\"", stats.missingFrames.load(memory_order_relaxed));
+		text.Add("tau2_frames_dropped_total", "counter", "", camera + ",reason=\"overrun\"", ring.GetOverruns());
+		text.Add("tau2_frames_dropped_total", "counter", "", camera + ",reason=\"ffc\"",
+				stats.ffcDropped.load(memory_order_relaxed));
+		text.Add("tau2_frames_incomplete_total", "counter", "Frames with missing lines or a failed transfer.",
+				camera, stats.incompleteFrames.load(memory_order_relaxed));
+		text.Add("tau2_retrieve_timeouts_total", "counter", "Failed buffer retrievals.", camera,
+				stats.timeouts.load(memory_order_relaxed));
+		if (scheduler != NULL) {
+			text.Add("tau2_ffc_total", "counter", "Scheduled flat field corrections.", camera,
+					scheduler->GetFFCCount());
+		}
+		text.Add("tau2_output_bytes_total", "counter", "Bytes written to the output.", camera,
+				writer.GetBytesWritten());
+		text.Add("tau2_queue_depth", "gauge", "Frames waiting in the ring for the output.", camera, ring.GetSize());
+		text.Add("tau2_queue_capacity", "gauge", "Slots of the ring.", camera, ring.GetCapacity());
+		float sensor = stats.sensorTemperatureC.load(memory_order_relaxed);
+		float housing = stats.housingTemperatureC.load(memory_order_relaxed);
+		if (!std::isnan(sensor)) {
+			text.Add("tau2_sensor_temperature_celsius", "gauge", "Sensor temperature of the latest frame.",
+					camera, sensor);
+		}
+		if (!std::isnan(housing)) {
+			text.Add("tau2_housing_temperature_celsius", "gauge", "Housing temperature of the latest frame.",
+					camera, housing);
+		}
+		double roundTripS = from->GetSerialRoundTripS();
+		if (!std::isnan(roundTripS)) {
+			text.Add("tau2_serial_round_trip_seconds", "gauge", "Smoothed time of one serial command.",
+					camera, roundTripS);
+		}
+		shared_ptr<const TransportStatistics> statistics;
+		if (transport != NULL) {
+			statistics = transport->GetSnapshot();
+		}
+		if (statistics) {
+			string labels = camera + ",transport=\"" + statistics->transport + "\"";
+			for (const pair<string, double> &value : statistics->values) {
+				text.Add("tau2_transport_" + transportMetricName(value.first), "untyped",
+						("Stream statistic " + value.first + " of the transport.").c_str(), labels, value.second);
+			}
+		}
+	});
+}
+
+/**
+ * Streams frames from an acquiring source until the frame count or duration
+ * in the options is reached or the source stops acquiring. A dedicated thread acquires into a ring of
+ * preallocated slots while the calling thread writes them with the given writer,
+ * so slow output never holds on to a pipeline buffer.
+ * Without a poller the temperatures are read once before streaming starts so the
+ * serial link stays quiet while frames are flowing.
+ * The summary is written to standard error in one piece, so streams running in
+ * parallel do not interleave.
+ * @return number of frames written
+ */
+unsigned long streamFrames(FrameSource &source, const CaptureOptions &opts, FrameWriter &writer,
+		const StreamContext &context = StreamContext()) {
+	FrameRing ring(opts.ringSlots, (size_t) source.GetResolutionX() * source.GetResolutionY());
+	AcquisitionStats stats;
+	unsigned long written = 0;
+	unsigned loggedGaps = 0;
+	TemperatureSnapshot initial;
+	ostringstream summary;
+
+	if (context.poller == NULL) {
+		initial = readTemperatures(source);
+	}
+
+	thread acquisition(acquireFrames, &source, cref(opts), &ring, &stats, &context, initial);
+	int metricsId = context.metrics != NULL ? addStreamMetrics(*context.metrics, source, stats, ring, writer, context) : 0;
+
+	for (;;) {
+		FrameSlot *slot = ring.BeginRead();
+		if (slot == NULL) {
+			if (stats.done.load(memory_order_acquire) && ring.GetSize() == 0) {
+				break;
+			}
+			this_thread::sleep_for(chrono::milliseconds(1));
+			continue;
+		}
+		logGap(context, *slot, loggedGaps);
+		// Frames after a failed write are only drained, the writer keeps the error
+		if (writer.GetError() == 0 && writeFrame(writer, *slot, context)) {
+			++written;
+		}
+		ring.CommitRead();
+	}
+	acquisition.join();
+	if (context.metrics != NULL) {
+		context.metrics->RemoveCollector(metricsId);
+	}
+
+	summarizeStream(summary, context, source, stats, written, writer, ring);
+	cerr << summary.str() << flush;
+	return written;
+}
+
+/**
+ * Streams hardware synchronized sources at once, one acquisition thread per source, and
+ * writes the frames in tuples: the frames the aligner matched to the same sync pulse are
+ * written to their source's writer with the tuple number as frame id, so equal ids in the
+ * outputs belong together. Frames of tuples that a source missed are flagged with
+ * frameFlagUnmatched, the missing frame is not written.
+ * @param contexts per source poller, scheduler and label, all on the same time base
+ * @return number of complete tuples
+ */
+unsigned long streamAlignedFrames(const vector<FrameSource *> &sources, const CaptureOptions &opts,
+		const vector<FrameWriter *> &writers, const vector<StreamContext> &contexts) {
+	typedef chrono::steady_clock Clock;
+	size_t n = sources.size();
+	deque<FrameRing> ringStorage;		// Stays in place as rings are added, unlike a vector
+	vector<FrameRing *> rings;
+	vector<AcquisitionStats> stats(n);
+	vector<unsigned long> written(n, 0);
+	vector<unsigned> loggedGaps(n);
+	vector<thread> acquisitions;
+	vector<int> metricsIds;
+	double slowestHz = 0.0;
+	ostringstream summary;
+
+	for (size_t i = 0; i < n; ++i) {
+		TemperatureSnapshot initial;
+		if (contexts[i].poller == NULL) {
+			initial = readTemperatures(*sources[i]);
+		}
+		double hz = sources[i]->GetCameraSpeedHz();
+		if (hz > 0.0 && (slowestHz == 0.0 || hz < slowestHz)) {
+			slowestHz = hz;
+		}
+		ringStorage.emplace_back(opts.ringSlots, (size_t) sources[i]->GetResolutionX() * sources[i]->GetResolutionY());
+		rings.push_back(&ringStorage.back());
+		acquisitions.push_back(thread(acquireFrames, sources[i], cref(opts), rings[i], &stats[i], &contexts[i], initial));
+		if (contexts[i].metrics != NULL) {
+			metricsIds.push_back(addStreamMetrics(*contexts[i].metrics, *sources[i], stats[i], *rings[i], *writers[i],
+					contexts[i]));
+		}
+	}
+
+	// Frames of one pulse arrive within half a period, a frame waits a few periods for the rest
+	double periodS = slowestHz > 0.0 ? 1.0 / slowestHz : 1.0 / 30.0;
+	FrameAligner aligner(rings, opts.alignMode, (uint64_t) (periodS * 0.5e9), (uint64_t) (periodS * 4e9));
+	vector<FrameSlot *> members;
+	uint64_t tuple = 0;
+
+	for (;;) {
+		bool final = true;
+		for (size_t i = 0; i < n; ++i) {
+			final &= stats[i].done.load(memory_order_acquire);
+		}
+		uint64_t nowNs = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - contexts[0].timeBase).count();
+		if (!aligner.Next(members, nowNs, final)) {
+			if (final) {
+				break;
+			}
+			this_thread::sleep_for(chrono::milliseconds(1));
+			continue;
+		}
+
+		bool complete = find(members.begin(), members.end(), (FrameSlot *) NULL) == members.end();
+		for (size_t i = 0; i < n; ++i) {
+			if (members[i] == NULL) {
+				continue;
+			}
+			members[i]->id = tuple;
+			if (!complete) {
+				members[i]->flags |= frameFlagUnmatched;
+			}
+			logGap(contexts[i], *members[i], loggedGaps[i]);
+			if (writers[i]->GetError() == 0 && writeFrame(*writers[i], *members[i], contexts[i])) {
+				++written[i];
+			}
+		}
+		aligner.Commit(members);
+		++tuple;
+	}
 
-	cout << "Performing flat field correction (click noise)..." << endl;
-	cam->GetSettings()->DoFFC();
-	sleep(1);
+	for (size_t i = 0; i < n; ++i) {
+		acquisitions[i].join();
+		if (contexts[i].metrics != NULL) {
+			contexts[i].metrics->RemoveCollector(metricsIds[i]);
+		}
+		summarizeStream(summary, contexts[i], *sources[i], stats[i], written[i], *writers[i], *rings[i]);
+		summary << contexts[i].label << "Tuples missed: " << aligner.GetMisses(i) << endl;
+	}
+	summary << "Tuples: " << aligner.GetTuples() << " complete, " << aligner.GetIncompleteTuples()
+			<< " with missing frames" << endl;
+	if (aligner.GetReanchors() > 0) {
+		summary << "Block IDs re-anchored on host time: " << aligner.GetReanchors() << " times" << endl;
+	}
+	cerr << summary.str() << flush;
+	return aligner.GetTuples();
 }
 
+/**
+ * Output path of camera i in multi camera captures: "-i" inserted before the extension.
+ */
+string cameraOutputPath(const string &path, size_t index) {
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of('/');
+	if (dot == string::npos || (slash != string::npos && dot < slash)) {
+		dot = path.size();
+	}
+	return path.substr(0, dot) + "-" + to_string(index) + path.substr(dot);
+}
 
-void retrievePixelValues(uint8_t *input_buffer, int width, int height) {
-	uint16_t * in_f16 = (uint16_t *) input_buffer; // Pixel is a two-byte number
-	int idx = 0;
+/**
+ * Creates the writer for the selected output format. Segments are written to the output
+ * path, per camera in multi camera captures, instead of the descriptor.
+ */
+FrameWriter *createFrameWriter(const CaptureOptions &opts, int fd, FrameSource &source, const StreamContext &context) {
+	int width = source.GetResolutionX();
+	int height = source.GetResolutionY();
 
-	height=width=1; //for debugging
+	switch (opts.format) {
+	case OutputFormat::Segments:
+		return new SegmentFrameWriter(opts.allCameras ? cameraOutputPath(opts.outputPath, context.camera)
+				: opts.outputPath, opts.segmentBytes, width, height);
+	case OutputFormat::Raw:
+		return new RawFrameWriter(fd, width, height);
+	case OutputFormat::Celsius:
+		return new CelsiusFrameWriter(fd, width, height, source.GetRadiometry());
+	case OutputFormat::PixelList:
+		return new TextFrameWriter(fd, width, height, TextLayout::PixelList);
+	default:
+		return new TextFrameWriter(fd, width, height, TextLayout::Matrix);
+	}
+}
+
+/**
+ * Applies the pipeline options to a source that is not acquiring yet.
+ */
+void configurePipeline(FrameSource &source, const CaptureOptions &opts, const StreamContext &context) {
+	if (!opts.pipeline.IsDefault() && !source.ConfigurePipeline(opts.pipeline)) {
+		cerr << context.label << "The pipeline settings could not be applied to this source" << endl;
+	}
+}
 
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < width; ++x) {
-			idx = y * width + x;
-			uint16_t raw = in_f16[idx];
-			cout << "Row: " << y << " Column: " << x << " Raw: " << raw << endl; 
+/**
+ * Starts the telemetry poller, FFC scheduler, pipeline sizer and transport monitor the options
+ * ask for on an acquiring source. A stream of more than one frame is always polled, every
+ * -T seconds unless -p says otherwise, so the temperatures stamped on the frames never get
+ * older than -T allows and the acquisition thread never waits for the serial link.
+ * @param context receives the started helpers
+ */
+void startStreamHelpers(FrameSource &source, const CaptureOptions &opts, StreamContext &context) {
+	if (opts.latencyIntervalS > 0.0) {
+		context.latencies = new StageLatencies();
+		context.latencyReporter = new LatencyReporter(*context.latencies, opts.latencyIntervalS, opts.latencyPath,
+				context.label);
+		if (!context.latencyReporter->Start()) {
+			cerr << context.label << "Cannot open " << opts.latencyPath << ": " << strerror(errno) << endl;
+		}
+	}
+	if (opts.pipeline.maxBufferCount > 0) {
+		uint32_t count = source.GetPipelineBufferCount();
+		if (count > 0) {
+			context.sizer = new PipelineSizer(source.GetCameraSpeedHz(), count, opts.pipeline.maxBufferCount);
+		} else {
+			cerr << context.label << "This source has no pipeline to size" << endl;
+		}
+	}
+
+	if (opts.transportIntervalS > 0.0) {
+		context.transport = new TransportMonitor(source, opts.transportIntervalS);
+		if (!context.transport->Start()) {
+			cerr << context.label << "This source has no transport statistics" << endl;
+			delete context.transport;
+			context.transport = NULL;
+		}
+	}
+
+	// Recordings carry their own temperatures, there is nothing to poll
+	static const double minPollIntervalS = 0.1;
+	if (!opts.replay && (opts.pollIntervalS > 0.0 || opts.frameCount != 1)) {
+		double intervalS = opts.pollIntervalS > 0.0 ? opts.pollIntervalS : max(opts.telemetryMaxAgeS, minPollIntervalS);
+		context.poller = new TelemetryPoller(source, intervalS);
+		context.poller->Start();
+	}
+
+	if (opts.scheduleFFC) {
+		context.scheduler = new FFCScheduler(source, opts.ffcSchedule, context.poller);
+		if (!context.scheduler->Start()) {
+			cerr << context.label << "This source does not support scheduled flat field corrections" << endl;
+			delete context.scheduler;
+			context.scheduler = NULL;
+		}
+	}
+}
+
+/**
+ * Stops what startStreamHelpers() started.
+ */
+void stopStreamHelpers(StreamContext &context) {
+	delete context.scheduler;
+	delete context.poller;
+	delete context.sizer;
+	delete context.latencyReporter;
+	delete context.latencies;
+	delete context.transport;
+	context.scheduler = NULL;
+	context.poller = NULL;
+	context.sizer = NULL;
+	context.latencyReporter = NULL;
+	context.latencies = NULL;
+	context.transport = NULL;
+}
+
+/**
+ * Runs a whole capture from a connected source: starts acquisition and, as the options
+ * ask, the telemetry poller and FFC scheduler, streams into the descriptor and stops again.
+ * @param context time base and summary label, poller and scheduler are filled in here
+ * @return number of frames written
+ */
+unsigned long captureSource(FrameSource &source, const CaptureOptions &opts, int fd, StreamContext context) {
+	FrameWriter *writer = createFrameWriter(opts, fd, source, context);
+
+	//start acquisition of the camera
+	configurePipeline(source, opts, context);
+	source.StartAcquisition();
+	startStreamHelpers(source, opts, context);
+
+	//keep the camera acquiring and pass every frame through
+	unsigned long written = streamFrames(source, opts, *writer, context);
+
+	stopStreamHelpers(context);
+
+	//stop acquisition of the camera
+	source.StopAcquisition();
+
+	delete writer;
+	return written;
+}
+
+/**
+ * Captures from synchronized sources into one descriptor each with frames written in
+ * aligned tuples. The sources are started in reverse order so the slaves are waiting
+ * before the master, source 0, sends its first pulse and all first frames share it.
+ * @param context time base shared by all sources, the labels are set per source
+ * @return number of complete tuples
+ */
+unsigned long captureSynchronized(const vector<FrameSource *> &sources, const CaptureOptions &opts,
+		const vector<int> &fds, const StreamContext &context) {
+	vector<FrameWriter *> writers;
+	vector<StreamContext> contexts(sources.size(), context);
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		contexts[i].label = "Camera " + to_string(i) + ": ";
+		contexts[i].camera = i;
+		writers.push_back(createFrameWriter(opts, fds[i], *sources[i], contexts[i]));
+		configurePipeline(*sources[i], opts, contexts[i]);
+	}
+	for (size_t i = sources.size(); i-- > 0;) {
+		sources[i]->StartAcquisition();
+	}
+	for (size_t i = 0; i < sources.size(); ++i) {
+		startStreamHelpers(*sources[i], opts, contexts[i]);
+	}
+
+	unsigned long tuples = streamAlignedFrames(sources, opts, writers, contexts);
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		stopStreamHelpers(contexts[i]);
+		sources[i]->StopAcquisition();
+		delete writers[i];
+	}
+	return tuples;
+}
+
+/**
+ * Starts the metrics exporter the options ask for.
+ * @return the exporter, NULL if none was asked for or it could not be started
+ */
+MetricsExporter *startMetricsExporter(const CaptureOptions &opts) {
+	if (opts.metricsTarget.empty()) {
+		return NULL;
+	}
+	MetricsExporter *exporter = new MetricsExporter(opts.metricsTarget, opts.metricsIntervalS);
+	if (!exporter->Start()) {
+		cerr << "Cannot export metrics to " << opts.metricsTarget << ": " << strerror(errno) << endl;
+		delete exporter;
+		return NULL;
+	}
+	return exporter;
+}
+
+/**
+ * Connects every camera and captures from all of them at once, one capture thread per
+ * camera writing to its own file. All host timestamps count from the same time base,
+ * whose wall clock time is printed, so frames of different cameras can be related.
+ * With synchronization camera 0 becomes the sync master and the others its slaves for
+ * the capture, and the frames are written aligned by captureSynchronized().
+ * @param metrics started exporter all cameras register their counters with, may be NULL
+ * @return 0 on success, -1 if a camera or output failed
+ */
+int captureAllCameras(const vector<Camera *> &cameras, const CaptureOptions &opts, ostream &info,
+		MetricsExporter *metrics = NULL) {
+	vector<CameraFrameSource *> sources;
+	vector<int> fds;
+	int result = 0;
+
+	for (size_t i = 0; i < cameras.size() && result == 0; ++i) {
+		info << "Camera " << i << ":" << endl;
+		if (cameras[i]->Connect() != 0) {
+			info << "Error connecting camera!" << endl;
+			result = -1;
+			break;
+		}
+		sources.push_back(new CameraFrameSource(cameras[i], opts.telemetryMaxAgeS));
+		if (!applyCameraProfile(*sources.back(), opts.profile, info)) {
+			info << "Error applying camera profile!" << endl;
+			result = -1;
+			break;
+		}
+		retrieveFileHeader(*sources.back(), info);
+		if (opts.synchronize) {
+			sources.back()->SetExternalSync(i == 0 ? CameraSerialSettings::ExternalSyncModes::Master
+					: CameraSerialSettings::ExternalSyncModes::Slave);
+			info << "External sync: " << (i == 0 ? "master" : "slave") << endl;
+		}
+
+		// The segment writer creates its own files
+		string path = cameraOutputPath(opts.outputPath, i);
+		int fd = opts.format == OutputFormat::Segments ? -1 : open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0 && opts.format != OutputFormat::Segments) {
+			info << "Cannot open " << path << ": " << strerror(errno) << endl;
+			result = -1;
+			break;
+		}
+		info << "Output: " << path << endl;
+		fds.push_back(fd);
+	}
+
+	if (result == 0) {
+		StreamContext context;
+		context.metrics = metrics;
+		chrono::system_clock::time_point wallBase = chrono::system_clock::now();
+		context.timeBase = chrono::steady_clock::now();
+		info << "Host timestamp base [ns since the epoch]: "
+				<< chrono::duration_cast<chrono::nanoseconds>(wallBase.time_since_epoch()).count() << endl;
+		info << string(74, '#') << endl;
+
+		if (opts.synchronize) {
+			captureSynchronized(vector<FrameSource *>(sources.begin(), sources.end()), opts, fds, context);
+		} else {
+			vector<thread> captures;
+			for (size_t i = 0; i < sources.size(); ++i) {
+				context.label = "Camera " + to_string(i) + ": ";
+				context.camera = i;
+				captures.push_back(thread(captureSource, ref(*sources[i]), cref(opts), fds[i], context));
+			}
+			for (thread &capture : captures) {
+				capture.join();
+			}
+		}
+	}
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		if (opts.synchronize) {
+			// A slave left without its master would stop delivering frames
+			sources[i]->SetExternalSync(CameraSerialSettings::ExternalSyncModes::Disabled);
+		}
+		delete sources[i];
+		cameras[i]->Disconnect();
+	}
+	for (int fd : fds) {
+		if (fd >= 0) {
+			close(fd);
 		}
 	}
+	return result;
 }
 
 #endif /* TAU2_CAPTURE */
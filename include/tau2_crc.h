@@ -0,0 +1,79 @@
+/**
+ * @file   tau2_crc.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  CRC-16-CCITT of Tau2 serial packets.
+ *
+ * Every command and response carries two CRCs, so the checksum runs on every packet of
+ * high-rate telemetry polling. tau2Crc16() uses slice-by-8 lookup tables, the bitwise
+ * tau2Crc16Bitwise() is kept as its reference, see bench/crc_bench.cpp.
+ */
+
+#ifndef TAU2_CRC_H
+#define TAU2_CRC_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * CRC-16-CCITT as used by the Tau2, one bit at a time. Reference for tau2Crc16().
+ */
+inline uint16_t tau2Crc16Bitwise(const uint8_t *data, size_t size, uint16_t crc = 0) {
+	for (size_t i = 0; i < size; ++i) {
+		crc ^= (uint16_t) data[i] << 8;
+		for (int bit = 0; bit < 8; ++bit) {
+			crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+/**
+ * Lookup tables for slice-by-8: table[k][b] is the CRC of byte b followed by k zero bytes.
+ */
+struct Tau2CrcTables {
+	uint16_t table[8][256];
+
+	Tau2CrcTables() {
+		for (int b = 0; b < 256; ++b) {
+			uint8_t byte = b;
+			table[0][b] = tau2Crc16Bitwise(&byte, 1);
+		}
+		for (int k = 1; k < 8; ++k) {
+			for (int b = 0; b < 256; ++b) {
+				uint16_t previous = table[k - 1][b];
+				table[k][b] = (uint16_t) (previous << 8) ^ table[0][previous >> 8];
+			}
+		}
+	}
+};
+
+/**
+ * CRC-16-CCITT (polynomial 0x1021) as used by the Tau2 for both packet CRCs,
+ * eight bytes per step.
+ * @param crc CRC of the preceding bytes, to continue a calculation
+ */
+inline uint16_t tau2Crc16(const uint8_t *data, size_t size, uint16_t crc = 0) {
+	static const Tau2CrcTables tables;
+	const uint16_t (*t)[256] = tables.table;
+
+	while (size >= 8) {
+		crc = t[7][data[0] ^ (crc >> 8)] ^ t[6][data[1] ^ (crc & 0xFF)] ^ t[5][data[2]] ^ t[4][data[3]]
+				^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+		data += 8;
+		size -= 8;
+	}
+	while (size-- > 0) {
+		crc = (uint16_t) (crc << 8) ^ t[0][(crc >> 8) ^ *data++];
+	}
+	return crc;
+}
+
+/**
+ * Checks the CRC that follows the data, as at the end of a packet header or packet.
+ */
+inline bool tau2CheckCrc(const uint8_t *data, size_t size) {
+	return tau2Crc16(data, size) == (uint16_t) (data[size] << 8 | data[size + 1]);
+}
+
+#endif /* TAU2_CRC_H */
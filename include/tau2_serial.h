@@ -0,0 +1,572 @@
+/**
+ * @file   tau2_serial.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Tau2 serial protocol with pipelined command batches.
+ *
+ * CameraSerialSettings sends one command at a time and sleeps a fixed time before reading
+ * the answer. Tau2Serial instead writes a batch of commands back to back, polls the receive
+ * buffer and, once both CRCs check out, matches every response to its command by its place
+ * in the order the commands were sent, so applying a set of settings takes a few round trips
+ * instead of a sleep per command.
+ *
+ * Packet layout (all fields big-endian):
+ *   process code 0x6E, status, reserved, function, byte count (2 bytes),
+ *   CRC1 over the first 6 bytes, data, CRC2 over everything before it.
+ * Both CRCs are CRC-16-CCITT (polynomial 0x1021, initial value 0), computed slice-by-8.
+ *
+ * Tau2Serial talks to the camera through a Tau2SerialLink. PvSerialLink opens its own port on
+ * the WIC serial bridge, so CameraSerialSettings must not be used while a batch is running;
+ * CameraTelemetry opens one per camera and it is used under the telemetry serial mutex.
+ */
+
+#ifndef TAU2_SERIAL_H
+#define TAU2_SERIAL_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <PvDeviceAdapter.h>
+#include <PvDeviceSerialPort.h>
+#include "CameraSerialSettings.h"
+#include "tau2_crc.h"
+
+typedef CameraSerialSettings::FunctionCodes Tau2Function;
+typedef CameraSerialSettings::ResponseStatuses Tau2Status;
+
+static const uint8_t tau2ProcessCode = 0x6E;
+static const size_t tau2HeaderSize = 8;		//* Up to and including CRC1
+static const unsigned tau2PollIntervalUs = 200;	//* Receive buffer polling interval
+
+/**
+ * Status byte of a response as ResponseStatuses.
+ */
+inline Tau2Status tau2Status(uint8_t status) {
+	switch (status) {
+	case 0x00:
+		return Tau2Status::CAM_OK;
+	case 0x03:
+		return Tau2Status::CAM_RANGE_ERROR;
+	case 0x04:
+		return Tau2Status::CAM_CHECKSUM_ERROR;
+	case 0x05:
+		return Tau2Status::CAM_UNDEFINED_PROCESS_ERROR;
+	case 0x06:
+		return Tau2Status::CAM_UNDEFINED_FUNCTION_ERROR;
+	case 0x07:
+		return Tau2Status::CAM_TIMEOUT_ERROR;
+	case 0x09:
+		return Tau2Status::CAM_BYTE_COUNT_ERROR;
+	case 0x0A:
+		return Tau2Status::CAM_FEATURE_NOT_ENABLED;
+	default:
+		return Tau2Status::UNKNOWN_ERROR;
+	}
+}
+
+/**
+ * Appends a complete command packet to the output.
+ */
+inline void tau2EncodePacket(Tau2Function function, const std::vector<uint8_t> &data, std::vector<uint8_t> &out) {
+	size_t start = out.size();
+	uint16_t crc;
+
+	out.push_back(tau2ProcessCode);
+	out.push_back(0);
+	out.push_back(0);
+	out.push_back((uint8_t) function);
+	out.push_back(data.size() >> 8);
+	out.push_back(data.size() & 0xFF);
+	crc = tau2Crc16(&out[start], 6);
+	out.push_back(crc >> 8);
+	out.push_back(crc & 0xFF);
+	out.insert(out.end(), data.begin(), data.end());
+	crc = tau2Crc16(&out[start], out.size() - start);
+	out.push_back(crc >> 8);
+	out.push_back(crc & 0xFF);
+}
+
+/**
+ * @return the value as command arguments
+ */
+inline std::vector<uint8_t> tau2Word(uint16_t value) {
+	return std::vector<uint8_t>{(uint8_t) (value >> 8), (uint8_t) (value & 0xFF)};
+}
+
+/**
+ * @return the 16 bit word at the given index of response data, 0 if the data is too short
+ */
+inline uint16_t tau2ReadWord(const std::vector<uint8_t> &data, size_t index = 0) {
+	return data.size() >= 2 * index + 2 ? data[2 * index] << 8 | data[2 * index + 1] : 0;
+}
+
+/**
+ * A decoded response packet.
+ */
+struct Tau2Packet {
+	uint8_t status = 0;
+	Tau2Function function = Tau2Function::NO_OP;
+	std::vector<uint8_t> data;
+};
+
+enum class Tau2DecodeResult {
+	Complete,	//* A packet was decoded
+	Incomplete,	//* More bytes are needed
+	Invalid		//* The bytes at the start are not a valid packet
+};
+
+/**
+ * Decodes the packet at the start of the buffer.
+ * @param consumed bytes taken by the packet when Complete, bytes to skip when Invalid
+ */
+inline Tau2DecodeResult tau2DecodePacket(const uint8_t *buffer, size_t size, Tau2Packet &packet, size_t &consumed) {
+	consumed = 1;
+	if (size == 0) {
+		return Tau2DecodeResult::Incomplete;
+	}
+	if (buffer[0] != tau2ProcessCode) {
+		return Tau2DecodeResult::Invalid;
+	}
+	if (size < tau2HeaderSize) {
+		return Tau2DecodeResult::Incomplete;
+	}
+	if (!tau2CheckCrc(buffer, 6)) {
+		return Tau2DecodeResult::Invalid;
+	}
+	size_t count = buffer[4] << 8 | buffer[5];
+	size_t total = tau2HeaderSize + count + 2;
+	if (size < total) {
+		return Tau2DecodeResult::Incomplete;
+	}
+	if (!tau2CheckCrc(buffer, total - 2)) {
+		return Tau2DecodeResult::Invalid;
+	}
+	packet.status = buffer[1];
+	packet.function = (Tau2Function) buffer[3];
+	packet.data.assign(buffer + tau2HeaderSize, buffer + tau2HeaderSize + count);
+	consumed = total;
+	return Tau2DecodeResult::Complete;
+}
+
+/**
+ * Byte stream to the camera.
+ */
+class Tau2SerialLink {
+public:
+	virtual ~Tau2SerialLink() {}
+
+	/**
+	 * @return false if the bytes could not be sent
+	 */
+	virtual bool Write(const uint8_t *data, size_t size) = 0;
+	/**
+	 * Reads what has arrived without waiting.
+	 * @return number of bytes read, 0 if nothing is ready
+	 */
+	virtual size_t ReadAvailable(uint8_t *buffer, size_t size) = 0;
+	/**
+	 * Drops bytes received so far.
+	 */
+	virtual void Flush() = 0;
+};
+
+/**
+ * Tau2SerialLink on the serial port of the WIC's Pleora bridge.
+ */
+class PvSerialLink : public Tau2SerialLink {
+public:
+	/**
+	 * Opens the serial port the settings use.
+	 */
+	PvSerialLink(CameraSerialSettings *settings) : adapter(settings->GetPvDevice()) {
+		opened = port.Open(&adapter, settings->GetPvDeviceSerial()).IsOK();
+	}
+
+	~PvSerialLink() {
+		if (opened) {
+			port.Close();
+		}
+	}
+
+	bool IsOpened() const {
+		return opened;
+	}
+
+	bool Write(const uint8_t *data, size_t size) {
+		uint32_t written = 0;
+		return opened && port.Write(data, size, written).IsOK() && written == size;
+	}
+
+	size_t ReadAvailable(uint8_t *buffer, size_t size) {
+		uint32_t ready = 0;
+		uint32_t read = 0;
+
+		if (!opened || !port.GetRxBytesReady(ready).IsOK() || ready == 0) {
+			return 0;
+		}
+		if (!port.Read(buffer, ready < size ? ready : size, read).IsOK()) {
+			return 0;
+		}
+		return read;
+	}
+
+	void Flush() {
+		if (opened) {
+			port.FlushRxBuffer();
+		}
+	}
+
+private:
+	PvDeviceAdapter adapter;
+	PvDeviceSerialPort port;
+	bool opened = false;
+};
+
+/**
+ * One command of a batch and, once executed, its response.
+ */
+struct Tau2Command {
+	Tau2Function function;
+	std::vector<uint8_t> data;			//* Arguments, empty for most getters
+	bool answered = false;				//* A response with valid CRCs arrived
+	Tau2Status status = Tau2Status::CAM_TIMEOUT_ERROR;
+	std::vector<uint8_t> response;			//* Data of the response
+
+	Tau2Command(Tau2Function function, const std::vector<uint8_t> &data = std::vector<uint8_t>()) :
+			function(function), data(data) {
+	}
+};
+
+/**
+ * Measured round trip time of one function code, from writing the command to
+ * decoding its response. Only commands sent with no other one ahead of them are measured,
+ * the others wait for the camera as well.
+ */
+struct Tau2Latency {
+	uint64_t samples = 0;
+	double smoothedUs = 0.0;	//* Exponentially weighted mean
+	double deviationUs = 0.0;	//* Exponentially weighted mean deviation
+	double maxUs = 0.0;
+};
+
+class Tau2Serial {
+public:
+	static const unsigned defaultTimeoutMs = 500;	//* Timeout of function codes not measured yet
+	static const unsigned minTimeoutMs = 10;
+	static const unsigned maxTimeoutMs = 2000;
+
+	/**
+	 * @param maxInFlight commands sent ahead of their responses, the Tau2 receive
+	 *        buffer holds a few short commands
+	 */
+	Tau2Serial(Tau2SerialLink &link, size_t maxInFlight = 4) : link(link),
+			maxInFlight(maxInFlight > 0 ? maxInFlight : 1) {
+	}
+
+	/**
+	 * Sends the commands in order, keeping up to maxInFlight of them outstanding, and
+	 * collects the responses. The camera answers in the order of the commands, so a
+	 * response belongs to the oldest command still owed one, checked by its function code;
+	 * responses of commands given up, also in an earlier batch, keep their place and are
+	 * dropped. A response with another function code is a late one of a command skipped
+	 * before, which is dropped too, else it belongs to the next owed command with its
+	 * function code and the ones before that were lost. Responses with a wrong CRC are
+	 * dropped.
+	 * The oldest outstanding command gets a timeout from the round trip time measured for
+	 * its function code (smoothed plus four times the deviation, as TCP does for
+	 * retransmissions), counted from when the response before it arrived, since the camera
+	 * only starts on a command after answering the previous one. The timeout doubles with
+	 * every command given up in a row, so a camera that is only slow is not met with a
+	 * run of timeouts. The wait ends as soon as the response is decoded and a missing one
+	 * is noticed quickly.
+	 * @param timeoutMs fixed timeout per command instead, 0 = measured
+	 * @return true if every command was answered with CAM_OK
+	 */
+	bool Execute(std::vector<Tau2Command> &commands, unsigned timeoutMs = 0) {
+		std::vector<uint8_t> packets;
+		size_t sent = 0;
+		size_t resolved = 0;		// Commands are resolved in order, resolved is the oldest outstanding
+		bool ok = true;
+
+		if (owed.empty() && skipped.empty()) {
+			// Nothing is on its way, what has arrived is noise
+			link.Flush();
+			received.clear();
+		}
+		for (Expected &expected : owed) {
+			expected.command = noCommand;
+		}
+		while (owed.size() > maxOwed) {
+			owed.pop_front();
+		}
+		sentAt.resize(commands.size());
+		headSince = Clock::now();
+		for (Tau2Command &command : commands) {
+			command.answered = false;
+			command.status = Tau2Status::CAM_TIMEOUT_ERROR;
+			command.response.clear();
+		}
+
+		while (resolved < commands.size()) {
+			if (sent < commands.size() && sent - resolved < maxInFlight) {
+				// Fill the window with one write
+				packets.clear();
+				size_t first = sent;
+				while (sent < commands.size() && sent - resolved < maxInFlight) {
+					tau2EncodePacket(commands[sent].function, commands[sent].data, packets);
+					++sent;
+				}
+				Clock::time_point now = Clock::now();
+				if (!link.Write(packets.data(), packets.size())) {
+					sent = first;
+					break;
+				}
+				for (size_t i = first; i < sent; ++i) {
+					sentAt[i] = now;
+					owed.push_back(Expected{commands[i].function, i, 0});
+				}
+			}
+
+			size_t matched = Receive(commands);
+			if (matched > 0) {
+				resolved += matched;
+				continue;
+			}
+			resolved += Expire(commands, resolved, sent, timeoutMs);
+			if (resolved < sent) {
+				std::this_thread::sleep_for(std::chrono::microseconds(tau2PollIntervalUs));
+			}
+		}
+
+		for (const Tau2Command &command : commands) {
+			ok &= command.answered && command.status == Tau2Status::CAM_OK;
+		}
+		return ok;
+	}
+
+	/**
+	 * Executes a single command.
+	 * @param timeoutMs fixed timeout instead of the measured one, 0 = measured
+	 * @return status of the response, CAM_TIMEOUT_ERROR if there was none
+	 */
+	Tau2Status Transact(Tau2Function function, const std::vector<uint8_t> &data, std::vector<uint8_t> &response,
+			unsigned timeoutMs = 0) {
+		std::vector<Tau2Command> commands(1, Tau2Command(function, data));
+
+		Execute(commands, timeoutMs);
+		response.swap(commands[0].response);
+		return commands[0].status;
+	}
+
+	/**
+	 * @return timeout for the next command with the function code
+	 */
+	unsigned GetTimeoutMs(Tau2Function function) const {
+		const Tau2Latency &l = latency[(uint8_t) function];
+		if (l.samples == 0) {
+			return defaultTimeoutMs;
+		}
+		double timeoutMs = (l.smoothedUs + 4.0 * l.deviationUs) / 1000.0;
+		return timeoutMs < minTimeoutMs ? minTimeoutMs : (timeoutMs > maxTimeoutMs ? maxTimeoutMs : (unsigned) timeoutMs + 1);
+	}
+
+	const Tau2Latency &GetLatency(Tau2Function function) const {
+		return latency[(uint8_t) function];
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	static const size_t noCommand = (size_t) -1;
+	static const size_t maxOwed = 64;		//* Responses of commands given up still waited for
+	static const unsigned maxBackoff = 64;
+
+	/**
+	 * A response the camera owes.
+	 */
+	struct Expected {
+		Tau2Function function;
+		size_t command;		//* Index in the running batch, noCommand once given up
+		uint64_t skippedAt;		//* Responses received when a later one arrived first
+	};
+
+	/**
+	 * Time the oldest outstanding command has been with the camera: since the response
+	 * before it, or since it was sent if that was later.
+	 */
+	Clock::time_point HeadStart(size_t head) const {
+		return sentAt[head] > headSince ? sentAt[head] : headSince;
+	}
+
+	/**
+	 * Reads what is available and matches complete packets against the owed responses.
+	 * @return number of commands resolved, answered or with their response lost
+	 */
+	size_t Receive(std::vector<Tau2Command> &commands) {
+		uint8_t chunk[256];
+		size_t n;
+		size_t matched = 0;
+
+		while ((n = link.ReadAvailable(chunk, sizeof(chunk))) > 0) {
+			received.insert(received.end(), chunk, chunk + n);
+		}
+
+		size_t offset = 0;
+		Clock::time_point now = Clock::now();
+		for (;;) {
+			Tau2Packet packet;
+			size_t consumed;
+			Tau2DecodeResult result = tau2DecodePacket(received.data() + offset, received.size() - offset,
+					packet, consumed);
+			if (result == Tau2DecodeResult::Incomplete) {
+				break;
+			}
+			offset += consumed;
+			if (result == Tau2DecodeResult::Invalid) {
+				continue;
+			}
+			++responses;
+			size_t k = 0;
+			if (owed.empty() || owed.front().function != packet.function) {
+				if (DropSkipped(packet.function)) {
+					continue;
+				}
+				while (k < owed.size() && owed[k].function != packet.function) {
+					++k;
+				}
+				if (k == owed.size()) {
+					continue;
+				}
+			}
+			// The responses owed before this one were lost or come out of order
+			size_t resolved = 0;
+			for (size_t i = 0; i < k; ++i) {
+				resolved += owed[i].command != noCommand;
+				owed[i].skippedAt = responses;
+				skipped.push_back(owed[i]);
+			}
+			while (skipped.size() > maxOwed) {
+				skipped.pop_front();
+			}
+			size_t index = owed[k].command;
+			owed.erase(owed.begin(), owed.begin() + k + 1);
+			if (index != noCommand) {
+				Tau2Command &command = commands[index];
+				command.answered = true;
+				command.status = tau2Status(packet.status);
+				command.response.swap(packet.data);
+				if (sentAt[index] >= headSince) {
+					Record(command.function, std::chrono::duration<double, std::micro>(now - sentAt[index]).count());
+				}
+				backoff = 1;
+				++resolved;
+			}
+			if (resolved > 0) {
+				matched += resolved;
+				headSince = now;
+			}
+		}
+		received.erase(received.begin(), received.begin() + offset);
+		return matched;
+	}
+
+	/**
+	 * Drops a skipped response with the function code, one that is still expected to arrive
+	 * out of order. With at most maxInFlight commands outstanding a response cannot come
+	 * later than that many others, so skipped responses are forgotten after them.
+	 * @return true if the response was one
+	 */
+	bool DropSkipped(Tau2Function function) {
+		while (!skipped.empty() && responses - skipped.front().skippedAt > maxInFlight) {
+			skipped.pop_front();
+		}
+		for (size_t i = 0; i < skipped.size(); ++i) {
+			if (skipped[i].function == function) {
+				skipped.erase(skipped.begin() + i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Gives up on the oldest outstanding command if it is past its deadline. Its response
+	 * is still expected and dropped when it arrives late.
+	 * @return number of commands given up
+	 */
+	size_t Expire(const std::vector<Tau2Command> &commands, size_t head, size_t sent, unsigned timeoutMs) {
+		if (head >= sent) {
+			return 0;
+		}
+		Clock::time_point now = Clock::now();
+		unsigned headTimeoutMs = timeoutMs > 0 ? timeoutMs : GetTimeoutMs(commands[head].function);
+		if (now < HeadStart(head) + std::chrono::milliseconds(headTimeoutMs) * backoff) {
+			return 0;
+		}
+		for (Expected &expected : owed) {
+			if (expected.command == head) {
+				expected.command = noCommand;
+			}
+		}
+		headSince = now;
+		backoff = backoff < maxBackoff ? 2 * backoff : maxBackoff;
+		return 1;
+	}
+
+	void Record(Tau2Function function, double us) {
+		Tau2Latency &l = latency[(uint8_t) function];
+		if (l.samples == 0) {
+			l.smoothedUs = us;
+			l.deviationUs = us / 2.0;
+		} else {
+			l.deviationUs += (std::fabs(us - l.smoothedUs) - l.deviationUs) / 4.0;
+			l.smoothedUs += (us - l.smoothedUs) / 8.0;
+		}
+		l.maxUs = us > l.maxUs ? us : l.maxUs;
+		++l.samples;
+	}
+
+	Tau2SerialLink &link;
+	size_t maxInFlight;
+	std::vector<uint8_t> received;
+	std::vector<Clock::time_point> sentAt;
+	Clock::time_point headSince;		//* Last response or give up, start of the oldest command's timeout
+	std::deque<Expected> owed;		//* Responses not received yet, in the order of the commands
+	std::deque<Expected> skipped;		//* Owed responses a later one arrived before
+	uint64_t responses = 0;			//* Valid responses received
+	unsigned backoff = 1;			//* Timeout multiplier, doubled by every command given up in a row
+	Tau2Latency latency[256];
+};
+
+/**
+ * Waits for a flat field correction started just before to finish, by polling the shutter
+ * position until the shutter has closed and opened again. If it is not seen closing within
+ * startMs the FFC is taken as already finished.
+ * @return false if the shutter position cannot be read or the shutter stayed closed,
+ *         the caller has to wait the FFC out itself
+ */
+inline bool tau2WaitForFFC(Tau2Serial &serial, unsigned timeoutMs = 2000, unsigned startMs = 150) {
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+	std::vector<uint8_t> response;
+	bool closed = false;
+
+	while (Clock::now() - start < std::chrono::milliseconds(timeoutMs)) {
+		if (serial.Transact(Tau2Function::SHUTTER_POSITION, std::vector<uint8_t>(), response) != Tau2Status::CAM_OK) {
+			return false;
+		}
+		if (tau2ReadWord(response) != 0) {
+			closed = true;
+		} else if (closed || Clock::now() - start >= std::chrono::milliseconds(startMs)) {
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return false;
+}
+
+#endif /* TAU2_SERIAL_H */
@@ -0,0 +1,131 @@
+/**
+ * @file   telemetry_poller.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Background thread reading the camera temperatures at a fixed interval.
+ *
+ * The serial round trips for sensor, housing and shutter temperature happen on the poller
+ * thread only. Each poll publishes a new immutable TemperatureSnapshot by atomically
+ * replacing a shared pointer, so the acquisition thread can stamp every frame with the
+ * latest values without waiting for the serial link.
+ *
+ * A poll reads the temperatures once, as one snapshot. On a camera it shares the serial
+ * link with the FFC scheduler and RadiometrySettings, which take the telemetry's serial
+ * mutex for their commands, so a poll waits while an FFC or a parameter change runs.
+ */
+
+#ifndef TELEMETRY_POLLER_H
+#define TELEMETRY_POLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "frame_source.h"
+
+/**
+ * Temperatures read in one poll.
+ */
+struct TemperatureSnapshot {
+	float sensorTemperatureC = 0.0f;
+	float housingTemperatureC = 0.0f;
+	float shutterTemperatureC = 0.0f;
+	uint64_t sequence = 0;				//* Number of the poll, starting at 1
+	std::chrono::steady_clock::time_point taken;	//* When the poll finished
+};
+
+class TelemetryPoller {
+public:
+	/**
+	 * @param intervalS time between the start of two polls in seconds
+	 */
+	TelemetryPoller(FrameSource &source, double intervalS) : source(source),
+			interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(intervalS))) {
+	}
+
+	~TelemetryPoller() {
+		Stop();
+	}
+
+	TelemetryPoller(const TelemetryPoller &) = delete;
+	TelemetryPoller &operator=(const TelemetryPoller &) = delete;
+
+	/**
+	 * Polls once on the calling thread, so a snapshot is available right away, and starts
+	 * the poller thread.
+	 */
+	void Start() {
+		if (poller.joinable()) {
+			return;
+		}
+		stopping = false;
+		Poll();
+		poller = std::thread(&TelemetryPoller::Run, this);
+	}
+
+	/**
+	 * Stops the poller thread, the last snapshot stays available.
+	 */
+	void Stop() {
+		if (!poller.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		poller.join();
+	}
+
+	/**
+	 * @return the latest snapshot, NULL before Start()
+	 */
+	std::shared_ptr<const TemperatureSnapshot> GetSnapshot() const {
+		return std::atomic_load(&snapshot);
+	}
+
+private:
+	void Run() {
+		std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + interval;
+		std::unique_lock<std::mutex> lock(wakeMutex);
+
+		while (!wake.wait_until(lock, next, [this] { return stopping; })) {
+			lock.unlock();
+			Poll();
+			lock.lock();
+			// Skip polls that were missed because the serial link was slow
+			next += interval;
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if (next < now) {
+				next = now + interval;
+			}
+		}
+	}
+
+	void Poll() {
+		std::shared_ptr<TemperatureSnapshot> next = std::make_shared<TemperatureSnapshot>();
+
+		double sensorC, housingC, shutterC;
+		source.GetTemperatures(sensorC, housingC, shutterC, true);
+		next->sensorTemperatureC = sensorC;
+		next->housingTemperatureC = housingC;
+		next->shutterTemperatureC = shutterC;
+		next->sequence = ++polls;
+		next->taken = std::chrono::steady_clock::now();
+		std::atomic_store(&snapshot, std::shared_ptr<const TemperatureSnapshot>(next));
+	}
+
+	FrameSource &source;
+	std::chrono::steady_clock::duration interval;
+	std::shared_ptr<const TemperatureSnapshot> snapshot;
+	uint64_t polls = 0;
+	std::thread poller;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+};
+
+#endif /* TELEMETRY_POLLER_H */
@@ -0,0 +1,202 @@
+/**
+ * @file   temperature_lut.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Table driven raw to temperature conversion for whole frames.
+ *
+ * The camera delivers 14-bit raw values, so the complete raw to temperature mapping for one
+ * set of radiometric parameters fits in 16384 entries. The table is filled once from the
+ * exact per pixel formula (Camera::CalculateTemperatureC) and frames are then converted
+ * with a plain table lookup per pixel.
+ *
+ * Every table records the parameter generation it was built for. A TemperatureLutSource
+ * bumps its generation whenever a radiometric parameter changes, and Refresh() rebuilds a
+ * table lazily the next time it is used.
+ */
+
+#ifndef TEMPERATURE_LUT_H
+#define TEMPERATURE_LUT_H
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Radiometric parameters a temperature table was built for.
+ */
+struct RadiometricParameterSet {
+	double emissivity = 0.0;
+	double reflectedTemperatureC = 0.0;
+	double atmosphericTemperatureC = 0.0;
+	double humidity = 0.0;			//* Relative humidity, 0..1
+	double distance = 0.0;			//* Object distance [m]
+	int rangeMode = 0;			//* CameraSerialSettings::RangeModes
+	std::string lens;
+};
+
+class TemperatureLut {
+public:
+	static const size_t entries = 1 << 14;	//* One entry per 14-bit raw value
+	static const uint16_t rawMask = entries - 1;
+
+	TemperatureLut() : table(entries, 0.0f) {
+	}
+
+	/**
+	 * Fills the table by evaluating the exact conversion once per raw value.
+	 * @param params parameter set the conversion currently uses
+	 * @param paramGeneration generation of that parameter set
+	 * @param rawToCelsius callable taking uint16_t raw and returning °C
+	 */
+	template <typename F>
+	void Build(const RadiometricParameterSet &params, uint64_t paramGeneration, F rawToCelsius) {
+		for (size_t raw = 0; raw < entries; ++raw) {
+			table[raw] = (float) rawToCelsius((uint16_t) raw);
+		}
+		parameters = params;
+		generation = paramGeneration;
+		valid = true;
+	}
+
+	/**
+	 * @return true if the table was built for this parameter generation
+	 */
+	bool IsCurrent(uint64_t paramGeneration) const {
+		return valid && generation == paramGeneration;
+	}
+
+	bool IsValid() const {
+		return valid;
+	}
+
+	const RadiometricParameterSet &GetParameters() const {
+		return parameters;
+	}
+
+	float Lookup(uint16_t raw) const {
+		return table[raw & rawMask];
+	}
+
+	/**
+	 * Converts a whole frame to °C. Bits above the 14-bit range are ignored.
+	 */
+	void Convert(const uint16_t *raw, float *celsius, size_t count) const {
+		const float *t = table.data();
+		for (size_t i = 0; i < count; ++i) {
+			celsius[i] = t[raw[i] & rawMask];
+		}
+	}
+
+private:
+	std::vector<float> table;
+	RadiometricParameterSet parameters;
+	uint64_t generation = 0;
+	bool valid = false;
+};
+
+/**
+ * Provider of the radiometric parameters behind a TemperatureLut.
+ */
+class TemperatureLutSource {
+public:
+	virtual ~TemperatureLutSource() {}
+
+	/**
+	 * @return counter that changes whenever a radiometric parameter changes
+	 */
+	uint64_t GetGeneration() const {
+		return generation.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * Rebuilds the table if the parameters changed since it was built.
+	 * Costs a single atomic load when nothing changed, so it can be called per frame.
+	 * @return true if the table was rebuilt
+	 */
+	bool Refresh(TemperatureLut &lut) {
+		if (lut.IsCurrent(GetGeneration())) {
+			return false;
+		}
+		BuildLut(lut);
+		return true;
+	}
+
+protected:
+	/**
+	 * Fills the table for the current parameters and generation.
+	 */
+	virtual void BuildLut(TemperatureLut &lut) = 0;
+
+	/**
+	 * Marks every table built so far as stale.
+	 */
+	void BumpGeneration() {
+		generation.fetch_add(1, std::memory_order_acq_rel);
+	}
+
+private:
+	std::atomic<uint64_t> generation{1};
+};
+
+/**
+ * Radiometry of T-linear raw values (0.04 K per count) with emissivity and reflected
+ * temperature compensation. Used where no camera formula is available: simulated frames
+ * and replayed recordings.
+ */
+class TLinearRadiometry : public TemperatureLutSource {
+public:
+	static constexpr double kelvinPerCount = 0.04;
+
+	TLinearRadiometry(double reflectedTemperatureC = 20.0) {
+		params.emissivity = 1.0;
+		params.reflectedTemperatureC = reflectedTemperatureC;
+		params.atmosphericTemperatureC = reflectedTemperatureC;
+		params.humidity = 0.5;
+		params.distance = 1.0;
+	}
+
+	void SetEmissivity(double value) {
+		std::lock_guard<std::mutex> lock(paramsMutex);
+		params.emissivity = value;
+		BumpGeneration();
+	}
+
+	void SetReflectedTemperatureC(double value) {
+		std::lock_guard<std::mutex> lock(paramsMutex);
+		params.reflectedTemperatureC = value;
+		BumpGeneration();
+	}
+
+	double CalculateTemperatureC(uint16_t raw) {
+		std::lock_guard<std::mutex> lock(paramsMutex);
+		return RawToTemperatureC(raw, params);
+	}
+
+	static double TemperatureToRaw(double celsius) {
+		return (celsius + 273.15) / kelvinPerCount;
+	}
+
+protected:
+	void BuildLut(TemperatureLut &lut) {
+		std::lock_guard<std::mutex> lock(paramsMutex);
+		RadiometricParameterSet p = params;
+		lut.Build(p, GetGeneration(), [&p](uint16_t raw) { return RawToTemperatureC(raw, p); });
+	}
+
+private:
+	static double RawToTemperatureC(uint16_t raw, const RadiometricParameterSet &p) {
+		double apparent = std::pow(raw * kelvinPerCount, 4.0);
+		double reflected = std::pow(p.reflectedTemperatureC + 273.15, 4.0);
+		double object = (apparent - (1.0 - p.emissivity) * reflected) / p.emissivity;
+		return (object > 0.0 ? std::pow(object, 0.25) : 0.0) - 273.15;
+	}
+
+	std::mutex paramsMutex;
+	RadiometricParameterSet params;
+};
+
+#endif /* TEMPERATURE_LUT_H */
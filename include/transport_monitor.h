@@ -0,0 +1,142 @@
+/**
+ * @file   transport_monitor.h
+ * @author Jamie McMillan (jamie.mcmillan@npl.co.uk)
+ * @date   October, 2026
+ * @brief  Background thread sampling the transport statistics of a source.
+ *
+ * The Pleora stream counts the blocks, resends and lost packets of the GigE Vision or
+ * USB3 Vision transport itself. Sampled next to the application's counters they tell
+ * frames the link lost apart from frames the host dropped. Samples are published as
+ * immutable snapshots through an atomically replaced shared pointer, like the
+ * temperatures of TelemetryPoller, and only the monitor thread reads the stream.
+ */
+
+#ifndef TRANSPORT_MONITOR_H
+#define TRANSPORT_MONITOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include "frame_source.h"
+
+class TransportMonitor {
+public:
+	/**
+	 * @param intervalS time between two samples in seconds
+	 */
+	TransportMonitor(FrameSource &source, double intervalS) : source(source),
+			interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(intervalS))) {
+	}
+
+	~TransportMonitor() {
+		Stop();
+	}
+
+	TransportMonitor(const TransportMonitor &) = delete;
+	TransportMonitor &operator=(const TransportMonitor &) = delete;
+
+	/**
+	 * Samples once on the calling thread and starts the monitor thread.
+	 * @return false if the source has no transport statistics
+	 */
+	bool Start() {
+		if (monitor.joinable()) {
+			return true;
+		}
+		if (!Sample()) {
+			return false;
+		}
+		stopping = false;
+		monitor = std::thread(&TransportMonitor::Run, this);
+		return true;
+	}
+
+	/**
+	 * Stops the monitor thread, the last snapshot stays available.
+	 */
+	void Stop() {
+		if (!monitor.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		monitor.join();
+	}
+
+	/**
+	 * @return the latest sample, NULL before Start()
+	 */
+	std::shared_ptr<const TransportStatistics> GetSnapshot() const {
+		return std::atomic_load(&snapshot);
+	}
+
+private:
+	void Run() {
+		std::unique_lock<std::mutex> lock(wakeMutex);
+
+		while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+			lock.unlock();
+			Sample();
+			lock.lock();
+		}
+	}
+
+	bool Sample() {
+		std::shared_ptr<TransportStatistics> next = std::make_shared<TransportStatistics>();
+
+		if (!source.ReadTransportStatistics(*next)) {
+			return false;
+		}
+		std::atomic_store(&snapshot, std::shared_ptr<const TransportStatistics>(next));
+		return true;
+	}
+
+	FrameSource &source;
+	std::chrono::steady_clock::duration interval;
+	std::shared_ptr<const TransportStatistics> snapshot;
+	std::thread monitor;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+};
+
+/**
+ * Writes "<label>Transport <transport>: Name value, ..." on one line.
+ */
+void formatTransportStatistics(std::ostream &out, const std::string &label, const TransportStatistics &statistics) {
+	out << label << "Transport " << statistics.transport << ":";
+	for (size_t i = 0; i < statistics.values.size(); ++i) {
+		out << (i == 0 ? " " : ", ") << statistics.values[i].first << " " << statistics.values[i].second;
+	}
+	out << std::endl;
+}
+
+/**
+ * @return the statistic's name in snake case, e.g. BlockIDsMissing as block_ids_missing
+ */
+std::string transportMetricName(const std::string &name) {
+	std::string snake;
+	for (size_t i = 0; i < name.size(); ++i) {
+		char c = name[i];
+		if (c >= 'A' && c <= 'Z') {
+			if (i > 0 && ((name[i - 1] >= 'a' && name[i - 1] <= 'z') || (name[i - 1] >= '0' && name[i - 1] <= '9'))) {
+				snake += '_';
+			}
+			snake += c - 'A' + 'a';
+		} else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+			snake += c;
+		} else {
+			snake += '_';
+		}
+	}
+	return snake;
+}
+
+#endif /* TRANSPORT_MONITOR_H */
@@ -5,64 +5,140 @@
  *		Jan Jerabek (jan.jerabek@workswell.cz), Jan Moravec (jan.moravec@workswell.cz)
  * @date   May, 2017
  * @brief  This returns to standard output the camera header information and each raw pixel value.
+ *         With -n or -t the camera keeps acquiring and every frame is streamed.
+ *         Frames are written as a comma separated matrix of raw values or temperatures,
+ *         a per pixel list or binary, see frame_writer.h, or into memory mapped segment
+ *         files, see segment_recording.h.
+ *         With -s frames come from a simulated camera and with -r from a raw recording,
+ *         so no hardware is needed.
+ *         While streaming the temperatures are polled in the background, every -T or
+ *         -p seconds, and stamped on every frame.
+ *         With -F flat field corrections are scheduled between measurement windows.
+ *         With -m all detected cameras are captured at once, each into its own file,
+ *         and with -M they are hardware synchronized and written in aligned tuples.
+ *         With -P and -G the depth of the acquisition pipeline is set or grown as needed.
+ *         With -L the latency of every capture stage is measured and reported periodically.
+ *         With -E live counters are exported in the Prometheus text format, with -S
+ *         together with the statistics of the camera's stream.
+ *         With -C a profile of camera settings is applied as one pipelined serial batch.
  */
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <iostream>
 #include <string>
 #include "CameraCenter.h"
 #include "tau2_capture.h"
 
-int main() {
-	uint16_t *buffer;
+int main(int argc, char *argv[]) {
+	CaptureOptions opts;
 
-	// Define start of header
-	cout << string(74, '#') << endl;
-
-	//creates a list of connected camera objects
-	CameraCenter *cameras = new CameraCenter("./src/"); // Path to folder containing license file
-
-	cout << "Number of detected cameras: " << cameras->getCameras().size() << endl;
-
-	if (cameras->getCameras().size() == 0) {
-		cout << "No camera found!" << endl;
+	if (!parseCaptureOptions(argc, argv, opts)) {
+		printUsage(argv[0]);
 		return -1;
 	}
-
-	//the first camera in the list
-	Camera *camera1 = cameras->getCameras().at(0);
-
-	//connect the camera
-	if (camera1->Connect() != 0) {
-		cout << "Error connecting camera!" << endl;
-		return -1;
+	if (!opts.profilePath.empty()) {
+		int line = loadCameraProfile(opts.profilePath, opts.profile);
+		if (line < 0) {
+			cerr << "Cannot read " << opts.profilePath << ": " << strerror(errno) << endl;
+			return -1;
+		} else if (line > 0) {
+			cerr << "Invalid setting in " << opts.profilePath << " at line " << line << endl;
+			return -1;
+		}
 	}
 
-	// Retrieve header information
-	retrieveFileHeader(camera1);
-
-	//start acquisition of the camera
-	camera1->StartAcquisition();
-
-	//get pointer to the current data
-	buffer = (uint16_t *) camera1->RetreiveBuffer();
+	// Binary frames on standard output must not be mixed with the text header
+	bool rawToStdout = opts.format == OutputFormat::Raw && opts.outputPath.empty();
+	ostream &info = rawToStdout ? cerr : cout;
+
+	// With -m every camera opens its own output, segments are created by their writer
+	int outputFd = STDOUT_FILENO;
+	if (!opts.outputPath.empty() && !opts.allCameras && opts.format != OutputFormat::Segments) {
+		outputFd = open(opts.outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (outputFd < 0) {
+			cerr << "Cannot open " << opts.outputPath << ": " << strerror(errno) << endl;
+			return -1;
+		}
+	}
 
-	int width = camera1->GetSettings()->GetResolutionX();
-	int height = camera1->GetSettings()->GetResolutionY();
+	// Define start of header
+	info << string(74, '#') << endl;
+
+	FrameSource *source;
+	Camera *camera1 = NULL;
+
+	if (opts.replay) {
+		ReplaySource *replay = new ReplaySource(opts.replayOptions);
+		int err = replay->Open();
+		if (err != 0) {
+			info << "Cannot play back " << opts.replayOptions.path << ": " << strerror(err) << endl;
+			return -1;
+		}
+		info << "Recording: " << opts.replayOptions.path << endl;
+		info << "Recording resolution: " << replay->GetResolutionX() << "x" << replay->GetResolutionY() << endl;
+		info << "Recording speed: " << replay->GetCameraSpeedHz() << "Hz" << endl;
+		source = replay;
+	} else if (opts.simulate) {
+		info << "Simulated camera resolution: " << opts.simulation.width << "x" << opts.simulation.height << endl;
+		info << "Simulated camera speed: " << opts.simulation.rateHz << "Hz" << endl;
+		source = new SimulatedCamera(opts.simulation);
+	} else {
+		//creates a list of connected camera objects
+		CameraCenter *cameras = new CameraCenter("./src/"); // Path to folder containing license file
+
+		info << "Number of detected cameras: " << cameras->getCameras().size() << endl;
+
+		if (cameras->getCameras().size() == 0) {
+			info << "No camera found!" << endl;
+			return -1;
+		}
+
+		if (opts.allCameras) {
+			MetricsExporter *metrics = startMetricsExporter(opts);
+			int result = captureAllCameras(cameras->getCameras(), opts, info, metrics);
+			delete metrics;
+			return result;
+		}
+
+		//the first camera in the list
+		camera1 = cameras->getCameras().at(0);
+
+		//connect the camera
+		if (camera1->Connect() != 0) {
+			info << "Error connecting camera!" << endl;
+			return -1;
+		}
+
+		// Apply the profile, then retrieve header information
+		CameraFrameSource *cameraSource = new CameraFrameSource(camera1, opts.telemetryMaxAgeS);
+		if (!applyCameraProfile(*cameraSource, opts.profile, info)) {
+			info << "Error applying camera profile!" << endl;
+			delete cameraSource;
+			camera1->Disconnect();
+			return -1;
+		}
+		retrieveFileHeader(*cameraSource, info);
+		source = cameraSource;
+	}
 
 	// Define end of header
-	cout << string(74, '#') << endl;
-
-	retrievePixelValues(camera1->RetreiveBuffer(), width, height);
+	info << string(74, '#') << endl;
 
-	//release buffer
-	camera1->ReleaseBuffer();
-
-	//stop acquisition of the camera
-	camera1->StopAcquisition();
+	StreamContext context;
+	context.metrics = startMetricsExporter(opts);
+	captureSource(*source, opts, outputFd, context);
+	delete context.metrics;
 
 	//disconnect the camera
-	camera1->Disconnect();
+	if (camera1 != NULL) {
+		camera1->Disconnect();
+	}
+
+	delete source;
+	if (outputFd != STDOUT_FILENO) {
+		close(outputFd);
+	}
 	return 0;
 }